@@ -0,0 +1,223 @@
+#include <kunit/test.h>
+#include <linux/module.h>
+#include <linux/version.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "hid-maschine-jam.h"
+
+// KUnit suite for the report to MIDI translation and the smartstrip LED rendering. Both cores
+// run on a default mapping without a device, the benchmark cases log ns per report.
+#define MASCHINE_JAM_TEST_ITERATIONS 10000
+#define MASCHINE_JAM_TEST_SHIFT_SYSEX_BYTES 13
+// every knob and button changes: two data bytes each, a status byte at the start and after the shift sysex
+#define MASCHINE_JAM_TEST_REPORT01_BYTES (((MASCHINE_JAM_NUMBER_KNOBS + MASCHINE_JAM_NUMBER_BUTTONS) * 2) + 2 + MASCHINE_JAM_TEST_SHIFT_SYSEX_BYTES)
+// every finger of every strip slides: two data bytes each behind one control change status
+#define MASCHINE_JAM_TEST_REPORT02_BYTES ((MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS * 2) + 1)
+// every button held and every finger touching, each message with its own status byte
+#define MASCHINE_JAM_TEST_RESYNC_BYTES (((MASCHINE_JAM_NUMBER_BUTTONS + (MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS * 2)) * 3) + MASCHINE_JAM_TEST_SHIFT_SYSEX_BYTES)
+#define MASCHINE_JAM_TEST_SMARTSTRIP_BYTES (MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_BITS / 8)
+
+struct maschine_jam_test_context {
+	struct maschine_jam_inputs inputs;
+	struct maschine_jam_midi_in_staging staging;
+	struct maschine_jam_smartstrip_display_state smartstrip_display_states[MASCHINE_JAM_NUMBER_SMARTSTRIPS];
+	uint8_t smartstrip_leds[MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS];
+	uint8_t report[MASCHINE_JAM_HID_INPUT_REPORT_MAX_BYTES];
+};
+
+// every knob and button flips between two reports
+static void maschine_jam_test_report01(uint8_t *report, unsigned int iteration){
+	memset(report, (iteration % 2) ? 0x00 : 0xFF, MASCHINE_JAM_HID_REPORT_01_BYTES);
+	report[0] = 0x01;
+}
+// every finger of every strip touches at touch_value, data is the report without its id
+static void maschine_jam_test_set_smartstrips(uint8_t *data, uint16_t timestamp, uint16_t touch_value){
+	uint8_t *smartstrip_data;
+	unsigned int i, j;
+
+	for (i = 0; i < MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
+		smartstrip_data = &data[i * MASCHINE_JAM_TEST_SMARTSTRIP_BYTES];
+		smartstrip_data[0] = timestamp & 0xFF;
+		smartstrip_data[1] = timestamp >> 8;
+		for (j = 0; j < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS; j++){
+			smartstrip_data[2 + (j * 2)] = touch_value & 0xFF;
+			smartstrip_data[3 + (j * 2)] = (touch_value >> 8) & 0x03;
+		}
+	}
+}
+// both fingers of every strip slide by one step per report
+static void maschine_jam_test_report02(uint8_t *report, unsigned int iteration){
+	report[0] = 0x02;
+	maschine_jam_test_set_smartstrips(&report[MASCHINE_JAM_HID_REPORT_ID_BYTES], iteration & 0xFFFF, 1 + (iteration % 0x3FF));
+}
+static void maschine_jam_test_fill_smartstrips(struct maschine_jam_test_context *context, uint8_t value){
+	unsigned int i;
+
+	for (i = 0; i < MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
+		context->smartstrip_display_states[i] = (struct maschine_jam_smartstrip_display_state){ .mode = MJ_SMARTSTRIP_DISPLAY_MODE_SINGLE, .color = 5, .value = value };
+	}
+}
+
+static void maschine_jam_test_report01_all_change(struct kunit *test){
+	struct maschine_jam_test_context *context = test->priv;
+
+	// from an untouched device every control changes, then back again
+	maschine_jam_test_report01(context->report, 0);
+	maschine_jam_translate_input_report(&context->inputs, &context->staging, context->report);
+	KUNIT_EXPECT_EQ(test, context->staging.length, MASCHINE_JAM_TEST_REPORT01_BYTES);
+	KUNIT_EXPECT_EQ(test, context->staging.buffer[0], 0x90);
+	maschine_jam_test_report01(context->report, 1);
+	maschine_jam_translate_input_report(&context->inputs, &context->staging, context->report);
+	KUNIT_EXPECT_EQ(test, context->staging.length, MASCHINE_JAM_TEST_REPORT01_BYTES);
+	// a repeated report changes nothing
+	maschine_jam_translate_input_report(&context->inputs, &context->staging, context->report);
+	KUNIT_EXPECT_EQ(test, context->staging.length, 0);
+}
+static void maschine_jam_test_report02_strip_sweep(struct kunit *test){
+	struct maschine_jam_test_context *context = test->priv;
+
+	// the first touch also sends the touch control, the steady state only slides
+	maschine_jam_test_report02(context->report, 0);
+	maschine_jam_translate_input_report(&context->inputs, &context->staging, context->report);
+	KUNIT_EXPECT_EQ(test, context->staging.length, (MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS * 4) + 1);
+	maschine_jam_test_report02(context->report, 1);
+	maschine_jam_translate_input_report(&context->inputs, &context->staging, context->report);
+	KUNIT_EXPECT_EQ(test, context->staging.length, MASCHINE_JAM_TEST_REPORT02_BYTES);
+	KUNIT_EXPECT_EQ(test, context->staging.buffer[0], 0xB1);
+}
+static void maschine_jam_test_resync_worst_case(struct kunit *test){
+	struct maschine_jam_test_context *context = test->priv;
+	struct maschine_jam_midi_config *midi_config;
+	unsigned int i, j, k;
+
+	// every button held and every finger touching, with statuses that never repeat back to back
+	memset(context->inputs.hid_report01_data_buttons, 0xFF, sizeof(context->inputs.hid_report01_data_buttons));
+	maschine_jam_test_set_smartstrips(context->inputs.hid_report02_data_smartstrips, 0, 0x3FF);
+	for (i = 0; i < MASCHINE_JAM_NUMBER_BUTTONS; i++){
+		context->inputs.midi_in_button_configs[i].status = 0x90 | (i % 2);
+	}
+	for (i = 0; i < MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
+		for (j = 0; j < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS; j++){
+			for (k = 0; k < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES; k++){
+				midi_config = &context->inputs.midi_in_smartstrip_configs[i][j][k];
+				midi_config->status = 0xB0 | k;
+			}
+		}
+	}
+	maschine_jam_stage_resync_midi_in(&context->inputs, &context->staging);
+	KUNIT_EXPECT_EQ(test, context->staging.length, MASCHINE_JAM_TEST_RESYNC_BYTES);
+	KUNIT_EXPECT_LE(test, context->staging.length, MASCHINE_JAM_MIDI_IN_BUFFER_BYTES);
+	// the last message is the slide of the last finger
+	KUNIT_EXPECT_EQ(test, context->staging.buffer[context->staging.length - 3], 0xB1);
+	KUNIT_EXPECT_EQ(test, context->staging.buffer[context->staging.length - 1], 0x3FF >> 3);
+}
+static void maschine_jam_test_smartstrip_render(struct kunit *test){
+	struct maschine_jam_test_context *context = test->priv;
+	unsigned int i;
+
+	// a full strip lights every LED, an empty one only the first
+	maschine_jam_test_fill_smartstrips(context, 127);
+	KUNIT_EXPECT_TRUE(test, maschine_jam_render_smartstrip_leds(context->smartstrip_display_states, context->smartstrip_leds));
+	for (i = 0; i < MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS; i++){
+		KUNIT_EXPECT_EQ(test, context->smartstrip_leds[i], 5);
+	}
+	maschine_jam_test_fill_smartstrips(context, 0);
+	KUNIT_EXPECT_TRUE(test, maschine_jam_render_smartstrip_leds(context->smartstrip_display_states, context->smartstrip_leds));
+	for (i = 0; i < MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS; i++){
+		KUNIT_EXPECT_EQ(test, context->smartstrip_leds[i], (i % MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP) == 0 ? 5 : 0);
+	}
+	// rendering the same states again changes nothing
+	KUNIT_EXPECT_FALSE(test, maschine_jam_render_smartstrip_leds(context->smartstrip_display_states, context->smartstrip_leds));
+}
+static void maschine_jam_test_smartstrip_render_monotonic(struct kunit *test){
+	struct maschine_jam_test_context *context = test->priv;
+	unsigned int value, i, lit_leds, previous_lit_leds = 1;
+
+	// a higher value never lights fewer LEDs of a single bar
+	for (value = 0; value < 128; value++){
+		maschine_jam_test_fill_smartstrips(context, value);
+		maschine_jam_render_smartstrip_leds(context->smartstrip_display_states, context->smartstrip_leds);
+		lit_leds = 0;
+		for (i = 0; i < MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP; i++){
+			lit_leds += context->smartstrip_leds[i] != 0;
+		}
+		KUNIT_EXPECT_GE(test, lit_leds, previous_lit_leds);
+		previous_lit_leds = lit_leds;
+	}
+	KUNIT_EXPECT_EQ(test, previous_lit_leds, MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP);
+}
+
+static void maschine_jam_test_benchmark_translate(struct kunit *test, const char *name, void (*make_report)(uint8_t *, unsigned int)){
+	struct maschine_jam_test_context *context = test->priv;
+	unsigned int i;
+	u64 start_ns, elapsed_ns;
+
+	start_ns = ktime_get_ns();
+	for (i = 0; i < MASCHINE_JAM_TEST_ITERATIONS; i++){
+		make_report(context->report, i);
+		maschine_jam_translate_input_report(&context->inputs, &context->staging, context->report);
+	}
+	elapsed_ns = ktime_get_ns() - start_ns;
+	kunit_info(test, "%s: %llu ns/report\n", name, elapsed_ns / MASCHINE_JAM_TEST_ITERATIONS);
+}
+static void maschine_jam_test_benchmark_report01(struct kunit *test){
+	maschine_jam_test_benchmark_translate(test, "report01_all_change", maschine_jam_test_report01);
+}
+static void maschine_jam_test_benchmark_report02(struct kunit *test){
+	maschine_jam_test_benchmark_translate(test, "report02_strip_sweep", maschine_jam_test_report02);
+}
+static void maschine_jam_test_benchmark_smartstrip_render(struct kunit *test){
+	struct maschine_jam_test_context *context = test->priv;
+	unsigned int i, j;
+	u64 start_ns, elapsed_ns;
+
+	maschine_jam_test_fill_smartstrips(context, 0);
+	start_ns = ktime_get_ns();
+	for (i = 0; i < MASCHINE_JAM_TEST_ITERATIONS; i++){
+		for (j = 0; j < MASCHINE_JAM_NUMBER_SMARTSTRIPS; j++){
+			context->smartstrip_display_states[j].value = (i + j) % 128;
+		}
+		maschine_jam_render_smartstrip_leds(context->smartstrip_display_states, context->smartstrip_leds);
+	}
+	elapsed_ns = ktime_get_ns() - start_ns;
+	kunit_info(test, "smartstrip_render: %llu ns/render\n", elapsed_ns / MASCHINE_JAM_TEST_ITERATIONS);
+}
+
+static int maschine_jam_test_init(struct kunit *test){
+	struct maschine_jam_test_context *context;
+
+	context = kunit_kzalloc(test, sizeof(struct maschine_jam_test_context), GFP_KERNEL);
+	if (context == NULL){
+		return -ENOMEM;
+	}
+	maschine_jam_initialize_inputs(&context->inputs);
+	test->priv = context;
+	return 0;
+}
+static struct kunit_case maschine_jam_test_cases[] = {
+	KUNIT_CASE(maschine_jam_test_report01_all_change),
+	KUNIT_CASE(maschine_jam_test_report02_strip_sweep),
+	KUNIT_CASE(maschine_jam_test_resync_worst_case),
+	KUNIT_CASE(maschine_jam_test_smartstrip_render),
+	KUNIT_CASE(maschine_jam_test_smartstrip_render_monotonic),
+	KUNIT_CASE(maschine_jam_test_benchmark_report01),
+	KUNIT_CASE(maschine_jam_test_benchmark_report02),
+	KUNIT_CASE(maschine_jam_test_benchmark_smartstrip_render),
+	{ }
+};
+static struct kunit_suite maschine_jam_test_suite = {
+	.name = "hid-maschine-jam",
+	.init = maschine_jam_test_init,
+	.test_cases = maschine_jam_test_cases,
+};
+kunit_test_suite(maschine_jam_test_suite);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("KUnit tests for the Maschine Jam report translation and LED rendering");
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+MODULE_IMPORT_NS("EXPORTED_FOR_KUNIT_TESTING");
+#else
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+#endif
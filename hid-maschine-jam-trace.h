@@ -0,0 +1,104 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM maschine_jam
+
+#if !defined(_HID_MASCHINE_JAM_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _HID_MASCHINE_JAM_TRACE_H
+
+#include <linux/tracepoint.h>
+
+// Raw HID input report as handed to maschine_jam_raw_event, report id included.
+TRACE_EVENT(maschine_jam_raw_report,
+	TP_PROTO(const u8 *data, int size),
+	TP_ARGS(data, size),
+	TP_STRUCT__entry(
+		__field(u8, report_id)
+		__field(int, size)
+		__dynamic_array(u8, data, size)
+	),
+	TP_fast_assign(
+		__entry->report_id = size > 0 ? data[0] : 0;
+		__entry->size = size;
+		memcpy(__get_dynamic_array(data), data, size);
+	),
+	TP_printk("report_id=0x%02x size=%d data=%s",
+		__entry->report_id,
+		__entry->size,
+		__print_hex(__get_dynamic_array(data), __entry->size)
+	)
+);
+
+// Control change decoded from a report, before it is encoded to MIDI bytes.
+// midi_type follows enum maschine_jam_midi_type.
+TRACE_EVENT(maschine_jam_midi_event,
+	TP_PROTO(int midi_type, u8 channel, u8 key, u8 value),
+	TP_ARGS(midi_type, channel, key, value),
+	TP_STRUCT__entry(
+		__field(int, midi_type)
+		__field(u8, channel)
+		__field(u8, key)
+		__field(u8, value)
+	),
+	TP_fast_assign(
+		__entry->midi_type = midi_type;
+		__entry->channel = channel;
+		__entry->key = key;
+		__entry->value = value;
+	),
+	TP_printk("type=%s channel=%u key=%u value=%u",
+		__print_symbolic(__entry->midi_type,
+			{ 0, "note" },
+			{ 1, "aftertouch" },
+			{ 2, "control_change" },
+			{ 3, "sysex" }),
+		__entry->channel,
+		__entry->key,
+		__entry->value
+	)
+);
+
+// MIDI bytes handed to snd_rawmidi_receive and how many the substream accepted.
+TRACE_EVENT(maschine_jam_rawmidi_receive,
+	TP_PROTO(const u8 *buffer, int length, int transmitted),
+	TP_ARGS(buffer, length, transmitted),
+	TP_STRUCT__entry(
+		__field(int, length)
+		__field(int, transmitted)
+		__dynamic_array(u8, buffer, length)
+	),
+	TP_fast_assign(
+		__entry->length = length;
+		__entry->transmitted = transmitted;
+		memcpy(__get_dynamic_array(buffer), buffer, length);
+	),
+	TP_printk("length=%d transmitted=%d bytes=%s",
+		__entry->length,
+		__entry->transmitted,
+		__print_hex(__get_dynamic_array(buffer), __entry->length)
+	)
+);
+
+// Time a report spent in the input ring between raw_event and the input worker.
+TRACE_EVENT(maschine_jam_input_latency,
+	TP_PROTO(u8 report_id, s64 latency_ns),
+	TP_ARGS(report_id, latency_ns),
+	TP_STRUCT__entry(
+		__field(u8, report_id)
+		__field(s64, latency_ns)
+	),
+	TP_fast_assign(
+		__entry->report_id = report_id;
+		__entry->latency_ns = latency_ns;
+	),
+	TP_printk("report_id=0x%02x latency_ns=%lld",
+		__entry->report_id,
+		__entry->latency_ns
+	)
+);
+
+#endif /* _HID_MASCHINE_JAM_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE hid-maschine-jam-trace
+#include <trace/define_trace.h>
@@ -1,8 +1,22 @@
 #include <linux/device.h>
 #include <linux/module.h>
 #include <linux/usb.h>
+#include <linux/version.h>
 #include <linux/mutex.h>
+#include <linux/rcupdate.h>
+#include <linux/bitops.h>
 #include <linux/hid.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
+#include <linux/cpumask.h>
+#include <linux/kfifo.h>
+#include <linux/moduleparam.h>
+#include <linux/percpu.h>
+#include <linux/seqlock.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <kunit/visibility.h>
 #include <sound/core.h>
 #include <sound/initval.h>
 #include <sound/rawmidi.h>
@@ -10,129 +24,289 @@
 #include <sound/seq_midi_event.h>
 
 #include "hid-ids.h"
+#include "hid-maschine-jam.h"
+#define CREATE_TRACE_POINTS
+#include "hid-maschine-jam-trace.h"
 
-#define MASCHINE_JAM_HID_REPORT_ID_BYTES 1
-#define MASCHINE_JAM_NUMBER_KNOBS 2
-#define MASCHINE_JAM_HID_REPORT_01_KNOB_BITS 4
-#define MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES (MASCHINE_JAM_NUMBER_KNOBS * MASCHINE_JAM_HID_REPORT_01_KNOB_BITS) / 8 // 1
-#define MASCHINE_JAM_NUMBER_BUTTONS 120
-#define MASCHINE_JAM_HID_REPORT_01_BUTTON_BITS 1
-#define MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES (MASCHINE_JAM_NUMBER_BUTTONS * MASCHINE_JAM_HID_REPORT_01_BUTTON_BITS) / 8 // 15
-#define MASCHINE_JAM_HID_REPORT_01_DATA_BYTES (MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES + MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES) // 16
-#define MASCHINE_JAM_HID_REPORT_01_BYTES (MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_HID_REPORT_01_DATA_BYTES) // 17
-#define MASCHINE_JAM_NUMBER_SMARTSTRIPS 8
-#define MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS 2
-enum maschine_jam_smartstrip_finger_mode{
-	MJ_SMARTSTRIP_FINGER_MODE_TOUCH = 0,
-	MJ_SMARTSTRIP_FINGER_MODE_SLIDE = 1
-};
-#define MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES 2
-#define MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_TIMESTAMP_BITS 16
-#define MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_TOUCH_VALUE_BITS 16
-#define MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_BITS (MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_TIMESTAMP_BITS + (MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_TOUCH_VALUE_BITS * 2)) // 48
-#define MASCHINE_JAM_HID_REPORT_02_SMARTSTRIPS_BYTES (MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_BITS) / 8 // 48
-#define MASCHINE_JAM_HID_REPORT_02_DATA_BYTES (MASCHINE_JAM_HID_REPORT_02_SMARTSTRIPS_BYTES) // 48
-#define MASCHINE_JAM_HID_REPORT_02_BYTES (MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_HID_REPORT_02_DATA_BYTES) // 49
+#define MASCHINE_JAM_INPUT_RING_DEPTH_DEFAULT 64
+#define MASCHINE_JAM_INPUT_RING_DEPTH_MIN 2
+#define MASCHINE_JAM_INPUT_RING_DEPTH_MAX 4096
+#define MASCHINE_JAM_CAPTURE_RING_BYTES (64 * 1024)
+#define MASCHINE_JAM_CAPTURE_REPORT_MAX_BYTES 64
+#define MASCHINE_JAM_REPLAY_SPEED_DEFAULT 1 // original speed, 0 replays without delays
 
 #define MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS VERIFY_OCTAL_PERMISSIONS(0664)
+#define MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS VERIFY_OCTAL_PERMISSIONS(0444)
+#define MASCHINE_JAM_SYSFS_WRITE_ONLY_ATTRIBUTE_PERMISSIONS VERIFY_OCTAL_PERMISSIONS(0200)
+#define MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES 6 // inputs/knobs through outputs/smartstrip_leds
 
-#define MASCHINE_JAM_SYSEX_MAX_LENGTH 28
 #define MASCHINE_JAM_MIDI_CHANNELS_MAX 16
 #define MASCHINE_JAM_MIDI_NOTES_MAX 128
 #define MASCHINE_JAM_MIDI_CONTROL_CHANGE_PARAMS_MAX 128
-enum maschine_jam_midi_type{
-	MJ_MIDI_TYPE_NOTE,
-	MJ_MIDI_TYPE_AFTERTOUCH,
-	MJ_MIDI_TYPE_CONTROL_CHANGE,
-	MJ_MIDI_TYPE_SYSEX
-};
 #define MJ_MIDI_TYPE_NOTE_STRING "note\n"
 #define MJ_MIDI_TYPE_AFTERTOUCH_STRING "aftertouch\n"
 #define MJ_MIDI_TYPE_CONTROL_CHANGE_STRING "control_change\n"
 
 #define MASCHINE_JAM_NUMBER_BUTTON_LEDS 53
 #define MASCHINE_JAM_NUMBER_PAD_LEDS 80
-#define MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP 11
-#define MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS (MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP)
-
-struct maschine_jam_midi_config {
-	enum maschine_jam_midi_type type;
-	uint8_t channel; // lower nibble 0-15
-	uint8_t key; // 0-127
-	uint8_t value_min; // 0
-	uint8_t value_max; // 127
-};
+#define MASCHINE_JAM_NUMBER_LEDS (MASCHINE_JAM_NUMBER_BUTTON_LEDS + MASCHINE_JAM_NUMBER_PAD_LEDS + MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS) // 221
+#define MASCHINE_JAM_HID_REPORT_80_BYTES (MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_BUTTON_LEDS) // 54
+#define MASCHINE_JAM_HID_REPORT_81_BYTES (MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_PAD_LEDS) // 81
+#define MASCHINE_JAM_HID_REPORT_82_BYTES (MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS) // 89
+#define MASCHINE_JAM_LED_REFRESH_RATE_DEFAULT 100 // Hz
+#define MASCHINE_JAM_LED_REFRESH_RATE_MIN 1
+#define MASCHINE_JAM_LED_REFRESH_RATE_MAX 1000
+#define MASCHINE_JAM_LED_WORKQUEUE_CPU_UNPINNED -1
 
+// also used as the report selector of a routing target
 enum maschine_jam_output_type{
-	MJ_OUTPUT_NOTE_MAPPING_SENTINAL,
-	MJ_OUTPUT_CONTROL_CHANGE_MAPPING_SENTINAL,
-	MJ_OUTPUT_BUTTON_LED_NODE,
-	MJ_OUTPUT_PAD_LED_NODE,
-	MJ_OUTPUT_SMARTSTRIP_LED_NODE
+	MJ_OUTPUT_BUTTON_LED_NODE, // report 0x80
+	MJ_OUTPUT_PAD_LED_NODE, // report 0x81
+	MJ_OUTPUT_SMARTSTRIP_LED_NODE // report 0x82
 };
+// the midi message an LED listens to
 struct maschine_jam_output_node {
 	enum maschine_jam_output_type type;
-	union {
-		struct { // MJ_OUTPUT_NOTE_MAPPING_SENTINAL || MJ_OUTPUT_CONTROL_CHANGE_MAPPING_SENTINAL
-			uint8_t channel;
-			union {
-				uint8_t note; // MJ_OUTPUT_NOTE_MAPPING_SENTINAL
-				uint8_t param; // MJ_OUTPUT_CONTROL_CHANGE_MAPPING_SENTINAL
-			};
-			struct maschine_jam_output_node* node_list_head;
-		};
-		struct { // MJ_OUTPUT_BUTTON_LED_NODE || MJ_OUTPUT_PAD_LED_NODE || MJ_OUTPUT_SMARTSTRIP_LED_NODE
-			uint8_t index;
-			struct maschine_jam_output_node* previous;
-			struct maschine_jam_output_node* next;
-		};
-	};
+	uint8_t index;
+	snd_seq_event_type_t midi_type; // SNDRV_SEQ_EVENT_NOTE || SNDRV_SEQ_EVENT_CONTROLLER
+	uint8_t channel; // 0-15
+	uint8_t key; // note or param, 0-127
+};
+
+// Routing index built from the output nodes for midi_out_trigger. Every (type, channel, key)
+// has a slot; the LEDs listening to slot n are targets[offsets[n]] up to targets[offsets[n+1]].
+// A published table is never modified: writers build a new one and swap it in under RCU, so
+// midi_out_trigger reads it without taking a lock.
+enum maschine_jam_midi_out_routing_type{
+	MJ_MIDI_OUT_ROUTING_NOTE,
+	MJ_MIDI_OUT_ROUTING_CONTROL_CHANGE,
+	MJ_MIDI_OUT_ROUTING_TYPES
+};
+#define MASCHINE_JAM_MIDI_OUT_ROUTING_SLOTS (MJ_MIDI_OUT_ROUTING_TYPES * MASCHINE_JAM_MIDI_CHANNELS_MAX * MASCHINE_JAM_MIDI_NOTES_MAX) // 4096
+struct maschine_jam_midi_out_target {
+	uint8_t report; // enum maschine_jam_output_type
+	uint8_t index;
+};
+struct maschine_jam_midi_out_routing_table {
+	uint16_t offsets[MASCHINE_JAM_MIDI_OUT_ROUTING_SLOTS + 1];
+	struct maschine_jam_midi_out_target targets[MASCHINE_JAM_NUMBER_LEDS];
+	struct rcu_head rcu;
+};
+
+// Streaming parser state for bytes written to the rawmidi output. It survives across trigger
+// calls, so a message split between two blocks is completed by the next one.
+#define MASCHINE_JAM_MIDI_OUT_CHUNK_BYTES 256
+struct maschine_jam_midi_out_parser {
+	uint8_t running_status; // 0 when no channel status is in effect
+	uint8_t data[2];
+	uint8_t data_length;
+	bool in_sysex;
+	unsigned int sysex_length; // counts every byte, only the first MASCHINE_JAM_SYSEX_MAX_LENGTH are kept
+	uint8_t sysex[MASCHINE_JAM_SYSEX_MAX_LENGTH];
+};
+
+// Output report transfer buffers are allocated once at probe, separately from driver_data so
+// they are DMA-safe. Each run snapshots the LED state into the next buffer, so a new snapshot
+// never touches the buffer of a transfer that may still be in flight.
+// dirty is set under the LED lock whenever a LED value actually changes and cleared when the
+// state is snapshotted; last_sent holds what the device last received, so a snapshot equal to
+// it is never sent again.
+// On USB each report owns one preallocated interrupt OUT URB on the LED endpoint, so the three
+// reports are in flight at the same time. While a report's URB is in flight new updates only
+// mark it dirty, and the completion submits the next snapshot itself. Without a USB endpoint
+// urb stays NULL and reports go out synchronously through hid_hw_output_report.
+// A failed transfer is resent with the next frame, up to MASCHINE_JAM_HID_OUTPUT_REPORT_RETRIES
+// times in a row; a stalled endpoint is not retried. The next LED change then starts over.
+#define MASCHINE_JAM_HID_OUTPUT_REPORT_BUFFERS 2
+#define MASCHINE_JAM_HID_OUTPUT_REPORT_RETRIES 3
+enum maschine_jam_hid_output_report_flag {
+	MJ_OUTPUT_REPORT_URB_IN_FLIGHT = 0,
+};
+struct maschine_jam_driver_data;
+struct maschine_jam_hid_output_report {
+	struct maschine_jam_driver_data *driver_data;
+	uint8_t report_id;
+	size_t size;
+	uint8_t *led_state;
+	spinlock_t *lock;
+	struct urb *urb;
+	unsigned long urb_flags;
+	unsigned int urb_failures; // consecutive failed transfers, only touched by the completion
+	uint8_t *buffers[MASCHINE_JAM_HID_OUTPUT_REPORT_BUFFERS];
+	unsigned int buffer_index;
+	bool dirty;
+	ktime_t dirty_since; // when the pending update first made the report dirty
+	ktime_t sent_dirty_since; // dirty_since of the snapshot last handed to the device
+	uint8_t *last_sent;
+	bool last_sent_valid;
+	unsigned long updates_coalesced;
+};
+
+// Statistics are kept per CPU so the hot paths only do an unlocked local increment; readers in
+// debugfs sum every CPU. Latencies go into log2 histograms, bucket n counting latencies of
+// [2^(n-1), 2^n) ns and bucket 0 counting zero.
+#define MASCHINE_JAM_LATENCY_HISTOGRAM_BUCKETS 32
+enum maschine_jam_stats_report {
+	MJ_STATS_REPORT_01,
+	MJ_STATS_REPORT_02,
+	MJ_STATS_REPORT_UNKNOWN,
+	MJ_STATS_REPORTS
+};
+struct maschine_jam_stats {
+	u64 reports_received[MJ_STATS_REPORTS];
+	u64 reports_bad_size;
+	u64 input_ring_overruns; // reports dropped because the input worker was behind
+	u64 capture_dropped; // records that did not fit the capture ring
+	u64 replay_reports;
+	u64 replay_live_reports_dropped; // device reports ignored while a replay is open
+	u64 midi_bytes_in; // delivered to the rawmidi input substream
+	u64 midi_bytes_out; // taken from the rawmidi output substream
+	u64 midi_out_unmapped; // note and control messages no LED listens to
+	u64 rawmidi_short_writes;
+	u64 led_reports_sent;
+	u64 led_reports_failed;
+	u64 input_latency[MASCHINE_JAM_LATENCY_HISTOGRAM_BUCKETS]; // report arrival to rawmidi delivery
+	u64 output_latency[MASCHINE_JAM_LATENCY_HISTOGRAM_BUCKETS]; // midi out trigger to transfer completion
+};
+
+// LED frames are paced by an hrtimer: the first report to become dirty arms the timer for one
+// refresh period after the previous frame, and the frame work then flushes every dirty report.
+// The frame work runs on a per-device high priority workqueue, optionally pinned to one CPU.
+// The work item starts all three reports; on USB it only submits them and does not wait.
+enum maschine_jam_led_frame_flag {
+	MJ_LED_FRAME_ARMED = 0,
+};
+
+// raw_event only timestamps a report and pushes it to the input ring, the input worker does
+// the report to MIDI translation. The worker is the only consumer. raw_event is called both
+// by the HID core and by a debugfs replay, so producers serialize on input_ring_producer_lock.
+struct maschine_jam_input_record {
+	ktime_t timestamp;
+	uint8_t size;
+	uint8_t data[MASCHINE_JAM_HID_INPUT_REPORT_MAX_BYTES];
+};
+
+// Capture stream format, shared by the debugfs capture and replay files: every report seen by
+// raw_event is one header followed by size report bytes, report id included. Timestamps are
+// CLOCK_MONOTONIC nanoseconds, replay only uses the differences between them.
+struct maschine_jam_capture_header {
+	__le64 timestamp_ns;
+	uint8_t size;
+} __packed;
+#define MASCHINE_JAM_CAPTURE_RECORD_MAX_BYTES (sizeof(struct maschine_jam_capture_header) + MASCHINE_JAM_CAPTURE_REPORT_MAX_BYTES)
+// A replay session owns the input path from open to close of the replay file, live reports
+// are dropped meanwhile so the recorded session is the only input. MJ_CAPTURE_SHUTDOWN is set
+// before the debugfs files are removed, it ends blocked capture reads and replay waits.
+enum maschine_jam_capture_flag {
+	MJ_CAPTURE_ENABLED = 0,
+	MJ_REPLAY_ACTIVE = 1,
+	MJ_CAPTURE_SHUTDOWN = 2,
 };
 
-enum maschine_jam_smartstrip_display_mode{
-	MJ_SMARTSTRIP_DISPLAY_MODE_SINGLE = 0x00,
-	MJ_SMARTSTRIP_DISPLAY_MODE_DOT = 0x01,
-	MJ_SMARTSTRIP_DISPLAY_MODE_PAN = 0x02,
-	MJ_SMARTSTRIP_DISPLAY_MODE_DUAL = 0x03,
+// Complete copy of the input configs and output nodes. A profile write is parsed into one, taken
+// from the current mapping so controls the profile does not list keep theirs, then applied in a
+// single step: the output nodes under midi_out_mapping_mutex with one routing table swap, the
+// input configs by the input worker between two reports.
+#define MASCHINE_JAM_PROFILE_VERSION 1
+#define MASCHINE_JAM_PROFILE_MAX_BYTES (32 * 1024)
+struct maschine_jam_profile {
+	struct maschine_jam_midi_config	midi_in_knob_configs[MASCHINE_JAM_NUMBER_KNOBS];
+	struct maschine_jam_midi_config	midi_in_button_configs[MASCHINE_JAM_NUMBER_BUTTONS];
+	struct maschine_jam_midi_config	midi_in_smartstrip_configs[MASCHINE_JAM_NUMBER_SMARTSTRIPS][MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS][MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES];
+	struct maschine_jam_output_node midi_out_button_led_nodes[MASCHINE_JAM_NUMBER_BUTTON_LEDS];
+	struct maschine_jam_output_node midi_out_pad_led_nodes[MASCHINE_JAM_NUMBER_PAD_LEDS];
+	struct maschine_jam_output_node midi_out_smartstrip_led_nodes[MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS];
 };
-struct maschine_jam_smartstrip_display_state {
-	enum maschine_jam_smartstrip_display_mode mode;
-	uint8_t color;
-	uint8_t value;
+
+// With no triggered rawmidi input the worker only keeps the cached report state current. When a
+// reader triggers the input, held buttons and touched smartstrips are sent once if midi_in_resync.
+enum maschine_jam_midi_in_flag {
+	MJ_MIDI_IN_RESYNC = 0,
+	MJ_MIDI_IN_APPLY_PROFILE = 1,
 };
 
+static unsigned int input_ring_depth = MASCHINE_JAM_INPUT_RING_DEPTH_DEFAULT;
+module_param(input_ring_depth, uint, 0444);
+MODULE_PARM_DESC(input_ring_depth, "HID input reports buffered ahead of the input worker, rounded up to a power of two (2-4096, default 64)");
+// The driver consumes every report itself. By default only hidraw is connected: with hidraw as
+// the sole claimer the HID core hands reports to hidraw and skips its own field parsing, and
+// without an open hidraw node that is a walk of an empty list. Without CONFIG_HIDRAW nothing
+// claims the device and the core parses every report again. generic_hid restores hid-input,
+// hiddev and the field parsing they need.
+static bool generic_hid;
+module_param(generic_hid, bool, 0444);
+MODULE_PARM_DESC(generic_hid, "Also connect hid-input and hiddev, which makes the HID core parse every report (default off)");
+static bool midi_in_resync = true;
+module_param(midi_in_resync, bool, 0644);
+MODULE_PARM_DESC(midi_in_resync, "Send held buttons and touched smartstrips when a MIDI reader starts (default on)");
+static char *builtin_profile_name = "default";
+module_param_named(profile, builtin_profile_name, charp, 0644);
+MODULE_PARM_DESC(profile, "Built-in mapping applied when a unit is probed: default or bitwig (default default)");
+
 struct maschine_jam_driver_data {
 	// Device Information
 	struct hid_device 		*mj_hid_device;
 
 	// Inputs
-	struct maschine_jam_midi_config	midi_in_knob_configs[MASCHINE_JAM_NUMBER_KNOBS];
-	uint8_t					hid_report01_data_knobs[MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES];
-	struct maschine_jam_midi_config	midi_in_button_configs[MASCHINE_JAM_NUMBER_BUTTONS];
-	uint8_t					hid_report01_data_buttons[MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES];
-	struct maschine_jam_midi_config	midi_in_smartstrip_configs[MASCHINE_JAM_NUMBER_SMARTSTRIPS][MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS][MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES];
-	uint8_t					hid_report02_data_smartstrips[MASCHINE_JAM_HID_REPORT_02_BYTES];
+	struct maschine_jam_inputs	inputs;
+	seqlock_t				input_state_lock; // writers of the report caches in inputs, read by inputs/state
+	DECLARE_KFIFO_PTR(input_ring, struct maschine_jam_input_record);
+	spinlock_t				input_ring_producer_lock;
+	struct workqueue_struct	*input_workqueue;
+	struct work_struct		input_work;
+	struct maschine_jam_profile	*midi_in_pending_profile; // input configs for the worker to apply
 
 	// Outputs
-	struct maschine_jam_output_node midi_out_note_mapping[MASCHINE_JAM_MIDI_CHANNELS_MAX][MASCHINE_JAM_MIDI_NOTES_MAX];
-	struct maschine_jam_output_node midi_out_control_change_mapping[MASCHINE_JAM_MIDI_CHANNELS_MAX][MASCHINE_JAM_MIDI_CONTROL_CHANGE_PARAMS_MAX];
 	struct maschine_jam_output_node midi_out_button_led_nodes[MASCHINE_JAM_NUMBER_BUTTON_LEDS];
 	struct maschine_jam_output_node midi_out_pad_led_nodes[MASCHINE_JAM_NUMBER_PAD_LEDS];
 	struct maschine_jam_output_node midi_out_smartstrip_led_nodes[MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS];
-	spinlock_t				midi_out_mapping_lock;
+	struct mutex			midi_out_mapping_mutex; // serializes output node changes and table rebuilds
+	struct maschine_jam_midi_out_routing_table __rcu *midi_out_routing_table;
 	uint8_t					hid_report_led_buttons[MASCHINE_JAM_NUMBER_BUTTON_LEDS];
 	spinlock_t				hid_report_led_buttons_lock;
-	struct work_struct		hid_report_led_buttons_work;
+	struct maschine_jam_hid_output_report hid_report_led_buttons_output;
 	uint8_t					hid_report_led_pads[MASCHINE_JAM_NUMBER_PAD_LEDS];
 	spinlock_t				hid_report_led_pads_lock;
-	struct work_struct		hid_report_led_pads_work;
+	struct maschine_jam_hid_output_report hid_report_led_pads_output;
 	uint8_t					hid_report_led_smartstrips[MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS];
 	struct maschine_jam_smartstrip_display_state hid_report_led_smartstrips_display_states[MASCHINE_JAM_NUMBER_SMARTSTRIPS];
 	spinlock_t				hid_report_led_smartstrips_lock;
-	struct work_struct		hid_report_led_smartstrips_work;
+	struct maschine_jam_hid_output_report hid_report_led_smartstrips_output;
+	struct hrtimer			led_frame_timer;
+	struct work_struct		led_frame_work;
+	struct workqueue_struct	*led_workqueue;
+	int						led_workqueue_cpu;
+	unsigned long			led_frame_flags;
+	atomic64_t				led_frame_last_ns;
+	unsigned int			led_refresh_rate;
+	unsigned long			led_frames_sent;
+
+	// Statistics
+	struct maschine_jam_stats __percpu *stats;
+	struct dentry			*debugfs_directory;
+
+	// Capture and Replay
+	DECLARE_KFIFO_PTR(capture_ring, uint8_t);
+	spinlock_t				capture_lock; // producer side of the capture ring and the enable bit
+	struct mutex			capture_mutex; // consumer side of the capture ring and its allocation
+	wait_queue_head_t		capture_wait;
+	unsigned long			capture_flags;
+	struct mutex			replay_mutex;
+	u32						replay_speed;
+	uint8_t					replay_record[MASCHINE_JAM_CAPTURE_RECORD_MAX_BYTES];
+	unsigned int			replay_record_length;
+	bool					replay_started;
+	u64						replay_first_timestamp_ns;
+	ktime_t					replay_start;
+
+	// Mapping Profile
+	struct mutex			profile_mutex; // profile staging buffer and profile application
+	char					*profile_staging;
+	size_t					profile_staging_length;
 
 	// Sysfs Interface
 	struct kobject *directory_inputs;
+	struct kernfs_node *inputs_state_dirent; // inputs/state, notified from the input worker
 	struct kobject *directory_inputs_knobs;
 	struct kobject *directory_inputs_buttons;
 	struct kobject *directory_inputs_smartstrips;
@@ -140,6 +314,8 @@ struct maschine_jam_driver_data {
 	struct kobject *directory_outputs_button_leds;
 	struct kobject *directory_outputs_pad_leds;
 	struct kobject *directory_outputs_smartstrip_leds;
+	struct maschine_jam_control_group *control_groups[MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES];
+	unsigned int number_control_groups[MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES];
 
 	// Sound/Midi Interface
 	struct snd_card			*sound_card;
@@ -147,112 +323,159 @@ struct maschine_jam_driver_data {
 	struct snd_rawmidi		*rawmidi_interface;
 	struct snd_rawmidi_substream	*midi_in_substream;
 	unsigned long			midi_in_up;
+	unsigned long			midi_in_flags;
 	spinlock_t				midi_in_lock;
-	struct snd_midi_event*	midi_in_decoder;
-	spinlock_t				midi_in_decoder_lock;
+	struct maschine_jam_midi_in_staging	midi_in_staging;
 	struct snd_rawmidi_substream	*midi_out_substream;
 	unsigned long			midi_out_up;
 	spinlock_t				midi_out_lock;
-	struct snd_midi_event*	midi_out_encoder;
-	spinlock_t				midi_out_encoder_lock;
+	struct maschine_jam_midi_out_parser	midi_out_parser;
+	spinlock_t				midi_out_parser_lock;
+	uint8_t					midi_out_chunk[MASCHINE_JAM_MIDI_OUT_CHUNK_BYTES];
 };
 
-static void maschine_jam_hid_write_led_buttons_report(struct work_struct *);
-static void maschine_jam_hid_write_led_pads_report(struct work_struct *);
-static void maschine_jam_hid_write_led_smartstrips_report(struct work_struct *);
-static int8_t maschine_jam_output_mapping_add(struct maschine_jam_output_node*, struct maschine_jam_output_node*);
-static void maschine_jam_initialize_driver_data(struct maschine_jam_driver_data *driver_data, struct hid_device *mj_hid_device){
-	unsigned int i, j, k, temp_key;
+static void maschine_jam_input_work(struct work_struct *);
+static enum hrtimer_restart maschine_jam_led_frame_timer_callback(struct hrtimer *);
+static void maschine_jam_led_frame_work(struct work_struct *);
+static void maschine_jam_midi_config_compile(struct maschine_jam_midi_config *midi_config){
+	uint8_t status;
 
-	// HID Device
-	driver_data->mj_hid_device = mj_hid_device;
+	switch(midi_config->type){
+		case MJ_MIDI_TYPE_NOTE:
+			status = 0x90; // note on
+			break;
+		case MJ_MIDI_TYPE_AFTERTOUCH:
+			status = 0xA0; // polyphonic key pressure
+			break;
+		case MJ_MIDI_TYPE_CONTROL_CHANGE:
+			status = 0xB0;
+			break;
+		default:
+			status = 0;
+			break;
+	}
+	WRITE_ONCE(midi_config->data1, midi_config->key & 0x7F);
+	WRITE_ONCE(midi_config->status, status ? status | (midi_config->channel & 0x0F) : 0);
+}
+// Default mapping with a clean report state: knobs and buttons send notes on channel 1, the
+// smartstrips control changes on channel 2.
+VISIBLE_IF_KUNIT void maschine_jam_initialize_inputs(struct maschine_jam_inputs *inputs){
+	unsigned int i, j, k, temp_key;
 
-	// Inputs
 	temp_key = 0;
 	for(i = 0; i < MASCHINE_JAM_NUMBER_KNOBS; i++){
-		driver_data->midi_in_knob_configs[i].type = MJ_MIDI_TYPE_NOTE;
-		driver_data->midi_in_knob_configs[i].channel = 0;
-		driver_data->midi_in_knob_configs[i].key = temp_key;
-		driver_data->midi_in_knob_configs[i].value_min = 0;
-		driver_data->midi_in_knob_configs[i].value_max = 0x7F; // 127
+		inputs->midi_in_knob_configs[i].type = MJ_MIDI_TYPE_NOTE;
+		inputs->midi_in_knob_configs[i].channel = 0;
+		inputs->midi_in_knob_configs[i].key = temp_key;
+		inputs->midi_in_knob_configs[i].value_min = 0;
+		inputs->midi_in_knob_configs[i].value_max = 0x7F; // 127
+		maschine_jam_midi_config_compile(&inputs->midi_in_knob_configs[i]);
 		temp_key++;
 	}
-	memset(driver_data->hid_report01_data_knobs, 0, sizeof(driver_data->hid_report01_data_knobs));
+	memset(inputs->hid_report01_data_knobs, 0, sizeof(inputs->hid_report01_data_knobs));
 	for(i = 0; i < MASCHINE_JAM_NUMBER_BUTTONS; i++){
-		driver_data->midi_in_button_configs[i].type = MJ_MIDI_TYPE_NOTE;
-		driver_data->midi_in_button_configs[i].channel = 0;
-		driver_data->midi_in_button_configs[i].key = temp_key;
-		driver_data->midi_in_button_configs[i].value_min = 0;
-		driver_data->midi_in_button_configs[i].value_max = 0x7F; // 127
+		inputs->midi_in_button_configs[i].type = MJ_MIDI_TYPE_NOTE;
+		inputs->midi_in_button_configs[i].channel = 0;
+		inputs->midi_in_button_configs[i].key = temp_key;
+		inputs->midi_in_button_configs[i].value_min = 0;
+		inputs->midi_in_button_configs[i].value_max = 0x7F; // 127
+		maschine_jam_midi_config_compile(&inputs->midi_in_button_configs[i]);
 		temp_key++;
 	}
-	memset(driver_data->hid_report01_data_buttons, 0, sizeof(driver_data->hid_report01_data_buttons));
+	memset(inputs->hid_report01_data_buttons, 0, sizeof(inputs->hid_report01_data_buttons));
 	temp_key = 0;
 	for(i = 0; i < MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
 		for(j=0; j < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS; j++){
 			for(k=0; k < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES; k++){
-				driver_data->midi_in_smartstrip_configs[i][j][k].type = MJ_MIDI_TYPE_CONTROL_CHANGE;
-				driver_data->midi_in_smartstrip_configs[i][j][k].channel = 1;
-				driver_data->midi_in_smartstrip_configs[i][j][k].key = temp_key;
-				driver_data->midi_in_smartstrip_configs[i][j][k].value_min = 0;
-				driver_data->midi_in_smartstrip_configs[i][j][k].value_max = 0x7F; // 127
+				inputs->midi_in_smartstrip_configs[i][j][k].type = MJ_MIDI_TYPE_CONTROL_CHANGE;
+				inputs->midi_in_smartstrip_configs[i][j][k].channel = 1;
+				inputs->midi_in_smartstrip_configs[i][j][k].key = temp_key;
+				inputs->midi_in_smartstrip_configs[i][j][k].value_min = 0;
+				inputs->midi_in_smartstrip_configs[i][j][k].value_max = 0x7F; // 127
+				maschine_jam_midi_config_compile(&inputs->midi_in_smartstrip_configs[i][j][k]);
 				temp_key++;
 			}
 		}
 	}
-	memset(driver_data->hid_report02_data_smartstrips, 0, sizeof(driver_data->hid_report02_data_smartstrips));
+	memset(inputs->hid_report02_data_smartstrips, 0, sizeof(inputs->hid_report02_data_smartstrips));
+}
+EXPORT_SYMBOL_IF_KUNIT(maschine_jam_initialize_inputs);
+static void maschine_jam_initialize_driver_data(struct maschine_jam_driver_data *driver_data, struct hid_device *mj_hid_device){
+	unsigned int i;
+
+	// HID Device
+	driver_data->mj_hid_device = mj_hid_device;
+
+	// Inputs
+	maschine_jam_initialize_inputs(&driver_data->inputs);
+	seqlock_init(&driver_data->input_state_lock);
+	spin_lock_init(&driver_data->input_ring_producer_lock);
+	driver_data->input_workqueue = NULL;
+	INIT_WORK(&driver_data->input_work, maschine_jam_input_work);
+	driver_data->midi_in_pending_profile = NULL;
 
 	// Outputs
-	for(i=0;i<MASCHINE_JAM_MIDI_CHANNELS_MAX;i++){
-		for(j=0;j<MASCHINE_JAM_MIDI_NOTES_MAX;j++){
-			driver_data->midi_out_note_mapping[i][j].type = MJ_OUTPUT_NOTE_MAPPING_SENTINAL;
-			driver_data->midi_out_note_mapping[i][j].channel = i;
-			driver_data->midi_out_note_mapping[i][j].note = j;
-			driver_data->midi_out_note_mapping[i][j].node_list_head = NULL;
-		}
-	}
-	for(i=0;i<MASCHINE_JAM_MIDI_CHANNELS_MAX;i++){
-		for(j=0;j<MASCHINE_JAM_MIDI_CONTROL_CHANGE_PARAMS_MAX;j++){
-			driver_data->midi_out_control_change_mapping[i][j].type = MJ_OUTPUT_CONTROL_CHANGE_MAPPING_SENTINAL;
-			driver_data->midi_out_control_change_mapping[i][j].channel = i;
-			driver_data->midi_out_control_change_mapping[i][j].param = j;
-			driver_data->midi_out_control_change_mapping[i][j].node_list_head = NULL;
-		}
-	}
 	for(i=0;i<MASCHINE_JAM_NUMBER_BUTTON_LEDS;i++){
 		driver_data->midi_out_button_led_nodes[i].type = MJ_OUTPUT_BUTTON_LED_NODE;
 		driver_data->midi_out_button_led_nodes[i].index = i;
-		driver_data->midi_out_button_led_nodes[i].previous = NULL;
-		driver_data->midi_out_button_led_nodes[i].next = NULL;
-		maschine_jam_output_mapping_add(&driver_data->midi_out_note_mapping[0][0], &driver_data->midi_out_button_led_nodes[i]);
+		driver_data->midi_out_button_led_nodes[i].midi_type = SNDRV_SEQ_EVENT_NOTE;
+		driver_data->midi_out_button_led_nodes[i].channel = 0;
+		driver_data->midi_out_button_led_nodes[i].key = 0;
 	}
 	for(i=0;i<MASCHINE_JAM_NUMBER_PAD_LEDS;i++){
 		driver_data->midi_out_pad_led_nodes[i].type = MJ_OUTPUT_PAD_LED_NODE;
 		driver_data->midi_out_pad_led_nodes[i].index = i;
-		driver_data->midi_out_pad_led_nodes[i].previous = NULL;
-		driver_data->midi_out_pad_led_nodes[i].next = NULL;
-		maschine_jam_output_mapping_add(&driver_data->midi_out_note_mapping[0][0], &driver_data->midi_out_pad_led_nodes[i]);
+		driver_data->midi_out_pad_led_nodes[i].midi_type = SNDRV_SEQ_EVENT_NOTE;
+		driver_data->midi_out_pad_led_nodes[i].channel = 0;
+		driver_data->midi_out_pad_led_nodes[i].key = 0;
 	}
 	for(i=0;i<MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS;i++){
 		driver_data->midi_out_smartstrip_led_nodes[i].type = MJ_OUTPUT_SMARTSTRIP_LED_NODE;
 		driver_data->midi_out_smartstrip_led_nodes[i].index = i;
-		driver_data->midi_out_smartstrip_led_nodes[i].previous = NULL;
-		driver_data->midi_out_smartstrip_led_nodes[i].next = NULL;
-		maschine_jam_output_mapping_add(&driver_data->midi_out_note_mapping[0][0], &driver_data->midi_out_smartstrip_led_nodes[i]);
+		driver_data->midi_out_smartstrip_led_nodes[i].midi_type = SNDRV_SEQ_EVENT_NOTE;
+		driver_data->midi_out_smartstrip_led_nodes[i].channel = 0;
+		driver_data->midi_out_smartstrip_led_nodes[i].key = 0;
 	}
-	spin_lock_init(&driver_data->midi_out_mapping_lock);
+	mutex_init(&driver_data->midi_out_mapping_mutex);
+	RCU_INIT_POINTER(driver_data->midi_out_routing_table, NULL);
 	memset(driver_data->hid_report_led_buttons, 0, sizeof(driver_data->hid_report_led_buttons));
 	spin_lock_init(&driver_data->hid_report_led_buttons_lock);
-	INIT_WORK(&driver_data->hid_report_led_buttons_work, maschine_jam_hid_write_led_buttons_report);
 	memset(driver_data->hid_report_led_pads, 0, sizeof(driver_data->hid_report_led_pads));
 	spin_lock_init(&driver_data->hid_report_led_pads_lock);
-	INIT_WORK(&driver_data->hid_report_led_pads_work, maschine_jam_hid_write_led_pads_report);
 	memset(driver_data->hid_report_led_smartstrips, 0, sizeof(driver_data->hid_report_led_smartstrips));
 	spin_lock_init(&driver_data->hid_report_led_smartstrips_lock);
-	INIT_WORK(&driver_data->hid_report_led_smartstrips_work, maschine_jam_hid_write_led_smartstrips_report);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+	hrtimer_setup(&driver_data->led_frame_timer, maschine_jam_led_frame_timer_callback, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+#else
+	hrtimer_init(&driver_data->led_frame_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	driver_data->led_frame_timer.function = maschine_jam_led_frame_timer_callback;
+#endif
+	INIT_WORK(&driver_data->led_frame_work, maschine_jam_led_frame_work);
+	driver_data->led_workqueue = NULL;
+	driver_data->led_workqueue_cpu = MASCHINE_JAM_LED_WORKQUEUE_CPU_UNPINNED;
+	driver_data->led_frame_flags = 0;
+	atomic64_set(&driver_data->led_frame_last_ns, 0);
+	driver_data->led_refresh_rate = MASCHINE_JAM_LED_REFRESH_RATE_DEFAULT;
+	driver_data->led_frames_sent = 0;
+
+	// Capture and Replay
+	spin_lock_init(&driver_data->capture_lock);
+	mutex_init(&driver_data->capture_mutex);
+	init_waitqueue_head(&driver_data->capture_wait);
+	driver_data->capture_flags = 0;
+	mutex_init(&driver_data->replay_mutex);
+	driver_data->replay_speed = MASCHINE_JAM_REPLAY_SPEED_DEFAULT;
+	driver_data->replay_record_length = 0;
+	driver_data->replay_started = false;
+
+	// Mapping Profile
+	mutex_init(&driver_data->profile_mutex);
+	driver_data->profile_staging = NULL;
+	driver_data->profile_staging_length = 0;
 
 	// Sysfs Interface
 	driver_data->directory_inputs = NULL;
+	driver_data->inputs_state_dirent = NULL;
 	driver_data->directory_inputs_knobs = NULL;
 	driver_data->directory_inputs_buttons = NULL;
 	driver_data->directory_inputs_smartstrips = NULL;
@@ -260,110 +483,145 @@ static void maschine_jam_initialize_driver_data(struct maschine_jam_driver_data
 	driver_data->directory_outputs_button_leds = NULL;
 	driver_data->directory_outputs_pad_leds = NULL;
 	driver_data->directory_outputs_smartstrip_leds = NULL;
+	for(i=0;i<MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES;i++){
+		driver_data->control_groups[i] = NULL;
+		driver_data->number_control_groups[i] = 0;
+	}
 
 	// Sound/Midi Interface
 	driver_data->sound_card = NULL;
 	driver_data->rawmidi_interface = NULL;
 	driver_data->midi_in_substream = NULL;
 	driver_data->midi_in_up = 0;
+	driver_data->midi_in_flags = 0;
 	spin_lock_init(&driver_data->midi_in_lock);
-	spin_lock_init(&driver_data->midi_in_decoder_lock);
+	driver_data->midi_in_staging.running_status = 0;
+	driver_data->midi_in_staging.length = 0;
 	driver_data->midi_out_substream = NULL;
 	driver_data->midi_out_up = 0;
 	spin_lock_init(&driver_data->midi_out_lock);
-	spin_lock_init(&driver_data->midi_out_encoder_lock);
+	memset(&driver_data->midi_out_parser, 0, sizeof(driver_data->midi_out_parser));
+	spin_lock_init(&driver_data->midi_out_parser_lock);
 }
 
-static int8_t maschine_jam_output_mapping_add(struct maschine_jam_output_node* mapping_sentinal, struct maschine_jam_output_node* output_node){
-	struct maschine_jam_output_node* current_node;
+static inline unsigned int maschine_jam_midi_out_routing_slot(enum maschine_jam_midi_out_routing_type routing_type, uint8_t channel, uint8_t key){
+	return (((routing_type * MASCHINE_JAM_MIDI_CHANNELS_MAX) + channel) * MASCHINE_JAM_MIDI_NOTES_MAX) + key;
+}
+static inline unsigned int maschine_jam_output_node_routing_slot(struct maschine_jam_output_node* output_node){
+	enum maschine_jam_midi_out_routing_type routing_type = MJ_MIDI_OUT_ROUTING_NOTE;
 
-	if (output_node->previous != NULL || output_node->next != NULL){
-		printk(KERN_ALERT "output_node must be removed before it can be added.\n");
-		return -1;
+	if (output_node->midi_type == SNDRV_SEQ_EVENT_CONTROLLER){
+		routing_type = MJ_MIDI_OUT_ROUTING_CONTROL_CHANGE;
 	}
-	if (mapping_sentinal->node_list_head == NULL){
-		mapping_sentinal->node_list_head = output_node;
-		output_node->previous = mapping_sentinal;
-	}else{
-		current_node = mapping_sentinal->node_list_head;
-		while (current_node->next != NULL){
-			current_node = current_node->next;
-		}
-		current_node->next = output_node;
-		output_node->previous = current_node;
+	return maschine_jam_midi_out_routing_slot(routing_type, output_node->channel, output_node->key);
+}
+static void maschine_jam_midi_out_routing_table_count_nodes(struct maschine_jam_midi_out_routing_table* routing_table, struct maschine_jam_output_node* output_nodes, unsigned int number_nodes){
+	unsigned int i;
+
+	for (i=0; i<number_nodes; i++){
+		routing_table->offsets[maschine_jam_output_node_routing_slot(&output_nodes[i])]++;
 	}
-	return 0;
 }
-static void maschine_jam_output_mapping_remove(struct maschine_jam_output_node* output_node){
-	if (output_node->previous != NULL){
-		if (output_node->previous->type == MJ_OUTPUT_NOTE_MAPPING_SENTINAL || output_node->previous->type == MJ_OUTPUT_CONTROL_CHANGE_MAPPING_SENTINAL){
-			output_node->previous->node_list_head = output_node->next;
-		}else{
-			output_node->previous->next = output_node->next;
-		}
-		if (output_node->next != NULL){
-			output_node->next->previous = output_node->previous;
-		}
+// walks backwards so nodes keep their array order within a slot
+static void maschine_jam_midi_out_routing_table_place_nodes(struct maschine_jam_midi_out_routing_table* routing_table, struct maschine_jam_output_node* output_nodes, unsigned int number_nodes){
+	unsigned int i;
+	struct maschine_jam_midi_out_target* target;
+
+	for (i=number_nodes; i>0; i--){
+		target = &routing_table->targets[--routing_table->offsets[maschine_jam_output_node_routing_slot(&output_nodes[i-1])]];
+		target->report = output_nodes[i-1].type;
+		target->index = output_nodes[i-1].index;
 	}
-	output_node->previous = NULL;
-	output_node->next = NULL;
 }
-static inline struct maschine_jam_output_node* maschine_jam_output_mapping_get_sentinal(struct maschine_jam_output_node* output_node){
-	struct maschine_jam_output_node* current_node;
+// counting sort of all LED nodes by routing slot
+static struct maschine_jam_midi_out_routing_table* maschine_jam_midi_out_routing_table_build(struct maschine_jam_output_node* button_led_nodes, struct maschine_jam_output_node* pad_led_nodes, struct maschine_jam_output_node* smartstrip_led_nodes){
+	unsigned int i;
+	struct maschine_jam_midi_out_routing_table* routing_table;
 
-	if (output_node->previous == NULL){
+	routing_table = kzalloc(sizeof(struct maschine_jam_midi_out_routing_table), GFP_KERNEL);
+	if (routing_table == NULL){
 		return NULL;
-	}else{
-		current_node = output_node->previous;
-		while(current_node->type == MJ_OUTPUT_BUTTON_LED_NODE || \
-			current_node->type == MJ_OUTPUT_PAD_LED_NODE || \
-			current_node->type == MJ_OUTPUT_SMARTSTRIP_LED_NODE)
-		{
-			current_node = current_node->previous;
-		}
-		if(current_node->type == MJ_OUTPUT_NOTE_MAPPING_SENTINAL || \
-			current_node->type == MJ_OUTPUT_CONTROL_CHANGE_MAPPING_SENTINAL)
-		{
-			return current_node;
-		}else{
-			return NULL;
-		}
 	}
+	maschine_jam_midi_out_routing_table_count_nodes(routing_table, button_led_nodes, MASCHINE_JAM_NUMBER_BUTTON_LEDS);
+	maschine_jam_midi_out_routing_table_count_nodes(routing_table, pad_led_nodes, MASCHINE_JAM_NUMBER_PAD_LEDS);
+	maschine_jam_midi_out_routing_table_count_nodes(routing_table, smartstrip_led_nodes, MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS);
+	// offsets[n] becomes the end of slot n, placing counts it back down to the start
+	for (i=1; i<=MASCHINE_JAM_MIDI_OUT_ROUTING_SLOTS; i++){
+		routing_table->offsets[i] += routing_table->offsets[i - 1];
+	}
+	maschine_jam_midi_out_routing_table_place_nodes(routing_table, smartstrip_led_nodes, MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS);
+	maschine_jam_midi_out_routing_table_place_nodes(routing_table, pad_led_nodes, MASCHINE_JAM_NUMBER_PAD_LEDS);
+	maschine_jam_midi_out_routing_table_place_nodes(routing_table, button_led_nodes, MASCHINE_JAM_NUMBER_BUTTON_LEDS);
+	return routing_table;
 }
-static int8_t maschine_jam_output_mapping_get_midi_info(struct maschine_jam_output_node* output_node, struct snd_seq_event* return_midi_event){
-	struct maschine_jam_output_node* sentinal_node;
+// swap in a built table, the previous one is freed after a grace period, must hold midi_out_mapping_mutex
+static void maschine_jam_midi_out_routing_table_publish(struct maschine_jam_driver_data* driver_data, struct maschine_jam_midi_out_routing_table* routing_table){
+	struct maschine_jam_midi_out_routing_table* old_routing_table;
 
-	sentinal_node = maschine_jam_output_mapping_get_sentinal(output_node);
-	if(sentinal_node == NULL){
-		printk(KERN_ALERT  "maschine_jam_output_mapping_get_midi_info: sentinal node not found\n");
-		return -1;
+	old_routing_table = rcu_dereference_protected(driver_data->midi_out_routing_table, lockdep_is_held(&driver_data->midi_out_mapping_mutex));
+	rcu_assign_pointer(driver_data->midi_out_routing_table, routing_table);
+	if (old_routing_table != NULL){
+		kfree_rcu(old_routing_table, rcu);
+	}
+}
+// rebuild the routing table from the output nodes and publish it, must hold midi_out_mapping_mutex
+static int maschine_jam_midi_out_routing_table_update(struct maschine_jam_driver_data* driver_data){
+	struct maschine_jam_midi_out_routing_table* routing_table;
+
+	routing_table = maschine_jam_midi_out_routing_table_build(driver_data->midi_out_button_led_nodes, driver_data->midi_out_pad_led_nodes, driver_data->midi_out_smartstrip_led_nodes);
+	if (routing_table == NULL){
+		return -ENOMEM;
+	}
+	maschine_jam_midi_out_routing_table_publish(driver_data, routing_table);
+	return 0;
+}
+// only once nothing can reach the table anymore, at probe failure or remove
+static void maschine_jam_midi_out_routing_table_free(struct maschine_jam_driver_data* driver_data){
+	kfree(rcu_dereference_protected(driver_data->midi_out_routing_table, 1));
+	RCU_INIT_POINTER(driver_data->midi_out_routing_table, NULL);
+}
+static int8_t maschine_jam_output_mapping_get_midi_info(struct maschine_jam_output_node* output_node, struct snd_seq_event* return_midi_event){
+	if(output_node->midi_type == SNDRV_SEQ_EVENT_NOTE){
+		return_midi_event->type = SNDRV_SEQ_EVENT_NOTE;
+		return_midi_event->data.note.channel = output_node->channel;
+		return_midi_event->data.note.note = output_node->key;
+		return 0;
+	}else if(output_node->midi_type == SNDRV_SEQ_EVENT_CONTROLLER){
+		return_midi_event->type = SNDRV_SEQ_EVENT_CONTROLLER;
+		return_midi_event->data.control.channel = output_node->channel;
+		return_midi_event->data.control.param = output_node->key;
+		return 0;
 	}else{
-		if(sentinal_node->type == MJ_OUTPUT_NOTE_MAPPING_SENTINAL){
-			return_midi_event->type = SNDRV_SEQ_EVENT_NOTE;
-			return_midi_event->data.note.channel = sentinal_node->channel;
-			return_midi_event->data.note.note = sentinal_node->note;
-			return 0;
-		}else if(sentinal_node->type == MJ_OUTPUT_CONTROL_CHANGE_MAPPING_SENTINAL){
-			return_midi_event->type = SNDRV_SEQ_EVENT_CONTROLLER;
-			return_midi_event->data.control.channel = sentinal_node->channel;
-			return_midi_event->data.control.param = sentinal_node->param;
-			return 0;
-		}else{
-			printk(KERN_ALERT  "maschine_jam_output_mapping_get_midi_info: invalid sentinal_node->type\n");
-			return -2;
-		}
+		printk(KERN_ALERT  "maschine_jam_output_mapping_get_midi_info: invalid output_node->midi_type\n");
+		return -2;
 	}
 }
+// must hold midi_out_mapping_mutex
 static int8_t maschine_jam_output_mapping_set_midi_info(struct maschine_jam_driver_data* driver_data, struct maschine_jam_output_node* output_node, struct snd_seq_event* midi_event){
-	maschine_jam_output_mapping_remove(output_node);
+	uint8_t channel, key;
+
 	if(midi_event->type == SNDRV_SEQ_EVENT_NOTE){
-		return 	maschine_jam_output_mapping_add(&driver_data->midi_out_note_mapping[midi_event->data.note.channel][midi_event->data.note.note], output_node);
+		channel = midi_event->data.note.channel;
+		key = midi_event->data.note.note;
 	}else if(midi_event->type == SNDRV_SEQ_EVENT_CONTROLLER){
-		return 	maschine_jam_output_mapping_add(&driver_data->midi_out_control_change_mapping[midi_event->data.control.channel][midi_event->data.control.param], output_node);
+		channel = midi_event->data.control.channel;
+		key = midi_event->data.control.param;
 	}else{
 		printk(KERN_ALERT "maschine_jam_output_mapping_set_midi_info - invalid midi_event->type\n");
 		return -1;
 	}
+	if (channel >= MASCHINE_JAM_MIDI_CHANNELS_MAX || key >= MASCHINE_JAM_MIDI_NOTES_MAX){
+		printk(KERN_ALERT "maschine_jam_output_mapping_set_midi_info - channel or key out of range\n");
+		return -1;
+	}
+	output_node->midi_type = midi_event->type;
+	output_node->channel = channel;
+	output_node->key = key;
+	if (maschine_jam_midi_out_routing_table_update(driver_data) != 0){
+		printk(KERN_ALERT "maschine_jam_output_mapping_set_midi_info - unable to rebuild routing table\n");
+		return -1;
+	}
+	return 0;
 }
 inline static int8_t maschine_jam_snd_seq_event_get_channel(struct snd_seq_event* midi_event){
 	if(midi_event->type == SNDRV_SEQ_EVENT_NOTE){
@@ -404,119 +662,404 @@ inline static void maschine_jam_snd_seq_event_set_key(struct snd_seq_event* midi
 	}
 }
 
-static void maschine_jam_hid_write_led_buttons_report(struct work_struct *work){
-	int ret = 0;
-	struct maschine_jam_driver_data *driver_data = container_of(work, struct maschine_jam_driver_data, hid_report_led_buttons_work);
-	unsigned char *buffer;
-
-	buffer = kzalloc(MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_BUTTON_LEDS, GFP_KERNEL);
-	buffer[0] = 0x80;
-	spin_lock(&driver_data->hid_report_led_buttons_lock);
-	memcpy(&buffer[MASCHINE_JAM_HID_REPORT_ID_BYTES], &driver_data->hid_report_led_buttons, MASCHINE_JAM_NUMBER_BUTTON_LEDS);
-	spin_unlock(&driver_data->hid_report_led_buttons_lock);
-	ret = hid_hw_output_report(driver_data->mj_hid_device, buffer, MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_BUTTON_LEDS);
-	//printk(KERN_NOTICE "maschine_jam_hid_write_report() - 0x80, ret=%d", ret);
-	kfree(buffer);
-}
-static void maschine_jam_hid_write_led_pads_report(struct work_struct *work){
-	int ret = 0;
-	struct maschine_jam_driver_data *driver_data = container_of(work, struct maschine_jam_driver_data, hid_report_led_pads_work);
-	unsigned char *buffer;
-
-	buffer = kzalloc(MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_PAD_LEDS, GFP_KERNEL);
-	buffer[0] = 0x81;
-	spin_lock(&driver_data->hid_report_led_pads_lock);
-	memcpy(&buffer[MASCHINE_JAM_HID_REPORT_ID_BYTES], &driver_data->hid_report_led_pads, MASCHINE_JAM_NUMBER_PAD_LEDS);
-	spin_unlock(&driver_data->hid_report_led_pads_lock);
-	ret = hid_hw_output_report(driver_data->mj_hid_device, buffer, MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_PAD_LEDS);
-	//printk(KERN_NOTICE "maschine_jam_hid_write_report() - 0x81, ret=%d", ret);
-	kfree(buffer);
-}
-static void maschine_jam_hid_write_led_smartstrips_report(struct work_struct *work){
-	int ret = 0;
-	struct maschine_jam_driver_data *driver_data = container_of(work, struct maschine_jam_driver_data, hid_report_led_smartstrips_work);
-	unsigned char *buffer;
-
-	buffer = kzalloc(MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS, GFP_KERNEL);
-	buffer[0] = 0x82;
-	spin_lock(&driver_data->hid_report_led_smartstrips_lock);
-	memcpy(&buffer[MASCHINE_JAM_HID_REPORT_ID_BYTES], &driver_data->hid_report_led_smartstrips, MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS);
-	spin_unlock(&driver_data->hid_report_led_smartstrips_lock);
-	ret = hid_hw_output_report(driver_data->mj_hid_device, buffer, MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS);
-	//printk(KERN_NOTICE "maschine_jam_hid_write_report() - 0x82, ret=%d", ret);
-	kfree(buffer);
-}
-
-static int maschine_jam_write_snd_seq_event(struct maschine_jam_driver_data *driver_data, struct snd_seq_event* event){
-	int8_t bytes_transmitted = 0, message_size = 0;
-	unsigned long flags;
-	unsigned char buffer[MASCHINE_JAM_SYSEX_MAX_LENGTH];
+static void maschine_jam_hid_output_report_free(struct maschine_jam_hid_output_report *output_report){
+	unsigned int i;
+
+	if (output_report->urb != NULL){
+		usb_kill_urb(output_report->urb);
+		usb_free_urb(output_report->urb);
+		output_report->urb = NULL;
+	}
+	for (i = 0; i < MASCHINE_JAM_HID_OUTPUT_REPORT_BUFFERS; i++){
+		kfree(output_report->buffers[i]);
+		output_report->buffers[i] = NULL;
+	}
+	kfree(output_report->last_sent);
+	output_report->last_sent = NULL;
+}
+static int maschine_jam_hid_output_report_alloc(struct maschine_jam_driver_data *driver_data, struct maschine_jam_hid_output_report *output_report, uint8_t report_id, size_t size, uint8_t *led_state, spinlock_t *lock){
+	unsigned int i;
+
+	output_report->driver_data = driver_data;
+	output_report->report_id = report_id;
+	output_report->size = size;
+	output_report->led_state = led_state;
+	output_report->lock = lock;
+	output_report->urb = NULL;
+	output_report->urb_flags = 0;
+	output_report->urb_failures = 0;
+	output_report->buffer_index = 0;
+	output_report->dirty = false;
+	output_report->last_sent_valid = false;
+	output_report->updates_coalesced = 0;
+	output_report->last_sent = kzalloc(size, GFP_KERNEL);
+	if (output_report->last_sent == NULL){
+		return -ENOMEM;
+	}
+	for (i = 0; i < MASCHINE_JAM_HID_OUTPUT_REPORT_BUFFERS; i++){
+		output_report->buffers[i] = kzalloc(size, GFP_KERNEL);
+		if (output_report->buffers[i] == NULL){
+			maschine_jam_hid_output_report_free(output_report);
+			return -ENOMEM;
+		}
+		output_report->buffers[i][0] = report_id;
+	}
+	return 0;
+}
+static inline uint8_t* maschine_jam_hid_output_report_next_buffer(struct maschine_jam_hid_output_report *output_report){
+	output_report->buffer_index = (output_report->buffer_index + 1) % MASCHINE_JAM_HID_OUTPUT_REPORT_BUFFERS;
+	return output_report->buffers[output_report->buffer_index];
+}
+// must be called with the report's LED lock held, after led_state was rewritten in place
+// returns true if the report just became dirty and a frame needs to be requested
+static inline bool maschine_jam_hid_output_report_mark_dirty(struct maschine_jam_hid_output_report *output_report){
+	if (output_report->dirty){
+		output_report->updates_coalesced++;
+		return false;
+	}
+	output_report->dirty = true;
+	output_report->dirty_since = ktime_get();
+	return true;
+}
+// must be called with the report's LED lock held, returns true if the report just became dirty
+static inline bool maschine_jam_hid_output_report_set_led(struct maschine_jam_hid_output_report *output_report, uint8_t *led_state, uint8_t value){
+	if (*led_state == value){
+		return false;
+	}
+	*led_state = value;
+	return maschine_jam_hid_output_report_mark_dirty(output_report);
+}
+static void maschine_jam_hid_output_report_complete(struct urb *);
+static int maschine_jam_hid_output_report_alloc_urb(struct maschine_jam_hid_output_report *output_report, struct usb_device *usb_device, struct usb_endpoint_descriptor *endpoint){
+	output_report->urb = usb_alloc_urb(0, GFP_KERNEL);
+	if (output_report->urb == NULL){
+		return -ENOMEM;
+	}
+	// the transfer buffer is pointed at the current snapshot on every submit
+	usb_fill_int_urb(
+		output_report->urb,
+		usb_device,
+		usb_sndintpipe(usb_device, endpoint->bEndpointAddress),
+		output_report->buffers[0],
+		output_report->size,
+		maschine_jam_hid_output_report_complete,
+		output_report,
+		endpoint->bInterval
+	);
+	return 0;
+}
+// a device that is not on USB, or has no interrupt OUT endpoint, keeps the synchronous path
+static int maschine_jam_create_hid_output_report_urbs(struct maschine_jam_driver_data *driver_data){
+	int error_code;
+	struct usb_interface *usb_interface;
+	struct usb_device *usb_device;
+	struct usb_endpoint_descriptor *endpoint;
+
+	if (!hid_is_usb(driver_data->mj_hid_device)){
+		return 0;
+	}
+	usb_interface = to_usb_interface(driver_data->mj_hid_device->dev.parent);
+	if (usb_find_int_out_endpoint(usb_interface->cur_altsetting, &endpoint) != 0){
+		printk(KERN_NOTICE "maschine_jam_create_hid_output_report_urbs: no interrupt out endpoint, using hid_hw_output_report\n");
+		return 0;
+	}
+	usb_device = interface_to_usbdev(usb_interface);
+	error_code = maschine_jam_hid_output_report_alloc_urb(&driver_data->hid_report_led_buttons_output, usb_device, endpoint);
+	if (error_code != 0){
+		goto failure_free_urbs;
+	}
+	error_code = maschine_jam_hid_output_report_alloc_urb(&driver_data->hid_report_led_pads_output, usb_device, endpoint);
+	if (error_code != 0){
+		goto failure_free_urbs;
+	}
+	error_code = maschine_jam_hid_output_report_alloc_urb(&driver_data->hid_report_led_smartstrips_output, usb_device, endpoint);
+	if (error_code != 0){
+		goto failure_free_urbs;
+	}
+	return 0;
+
+failure_free_urbs:
+	usb_free_urb(driver_data->hid_report_led_smartstrips_output.urb);
+	driver_data->hid_report_led_smartstrips_output.urb = NULL;
+	usb_free_urb(driver_data->hid_report_led_pads_output.urb);
+	driver_data->hid_report_led_pads_output.urb = NULL;
+	usb_free_urb(driver_data->hid_report_led_buttons_output.urb);
+	driver_data->hid_report_led_buttons_output.urb = NULL;
+	return error_code;
+}
+static int maschine_jam_create_hid_output_reports(struct maschine_jam_driver_data *driver_data){
+	int error_code;
+
+	error_code = maschine_jam_hid_output_report_alloc(driver_data, &driver_data->hid_report_led_buttons_output, 0x80, MASCHINE_JAM_HID_REPORT_80_BYTES, driver_data->hid_report_led_buttons, &driver_data->hid_report_led_buttons_lock);
+	if (error_code != 0){
+		goto return_error_code;
+	}
+	error_code = maschine_jam_hid_output_report_alloc(driver_data, &driver_data->hid_report_led_pads_output, 0x81, MASCHINE_JAM_HID_REPORT_81_BYTES, driver_data->hid_report_led_pads, &driver_data->hid_report_led_pads_lock);
+	if (error_code != 0){
+		goto failure_free_led_buttons_output;
+	}
+	error_code = maschine_jam_hid_output_report_alloc(driver_data, &driver_data->hid_report_led_smartstrips_output, 0x82, MASCHINE_JAM_HID_REPORT_82_BYTES, driver_data->hid_report_led_smartstrips, &driver_data->hid_report_led_smartstrips_lock);
+	if (error_code != 0){
+		goto failure_free_led_pads_output;
+	}
+	error_code = maschine_jam_create_hid_output_report_urbs(driver_data);
+	if (error_code != 0){
+		goto failure_free_led_smartstrips_output;
+	}
+	goto return_error_code;
+
+failure_free_led_smartstrips_output:
+	maschine_jam_hid_output_report_free(&driver_data->hid_report_led_smartstrips_output);
+failure_free_led_pads_output:
+	maschine_jam_hid_output_report_free(&driver_data->hid_report_led_pads_output);
+failure_free_led_buttons_output:
+	maschine_jam_hid_output_report_free(&driver_data->hid_report_led_buttons_output);
+return_error_code:
+	return error_code;
+}
+// Completions of a failed transfer re-arm the frame timer, so the URBs are stopped before the
+// timer and the frame work are cancelled. A poisoned URB also refuses new submits.
+static void maschine_jam_stop_hid_output_reports(struct maschine_jam_driver_data *driver_data){
+	if (driver_data->hid_report_led_buttons_output.urb != NULL){
+		usb_poison_urb(driver_data->hid_report_led_buttons_output.urb);
+	}
+	if (driver_data->hid_report_led_pads_output.urb != NULL){
+		usb_poison_urb(driver_data->hid_report_led_pads_output.urb);
+	}
+	if (driver_data->hid_report_led_smartstrips_output.urb != NULL){
+		usb_poison_urb(driver_data->hid_report_led_smartstrips_output.urb);
+	}
+}
+static void maschine_jam_delete_hid_output_reports(struct maschine_jam_driver_data *driver_data){
+	maschine_jam_hid_output_report_free(&driver_data->hid_report_led_smartstrips_output);
+	maschine_jam_hid_output_report_free(&driver_data->hid_report_led_pads_output);
+	maschine_jam_hid_output_report_free(&driver_data->hid_report_led_buttons_output);
+}
 
-	spin_lock_irqsave(&driver_data->midi_in_decoder_lock, flags);
-	message_size = snd_midi_event_decode(driver_data->midi_in_decoder, buffer, MASCHINE_JAM_SYSEX_MAX_LENGTH, event);
-	spin_unlock_irqrestore(&driver_data->midi_in_decoder_lock, flags);
+static inline unsigned int maschine_jam_latency_bucket(ktime_t start){
+	s64 latency_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
 
-	if (message_size <= 0){
-		printk(KERN_ALERT "maschine_jam_write_snd_seq_event: message_size: %d <= 0\n", message_size);
+	if (latency_ns <= 0){
 		return 0;
 	}
+	return min_t(unsigned int, fls64(latency_ns), MASCHINE_JAM_LATENCY_HISTOGRAM_BUCKETS - 1);
+}
+// snapshot led_state under lock and send it, unless it matches what the device last received
+// returns the bytes sent or submitted, 0 if nothing went out, cannot block on USB
+static int maschine_jam_hid_send_output_report(struct maschine_jam_driver_data *driver_data, struct maschine_jam_hid_output_report *output_report){
+	int ret;
+	unsigned long flags;
+	uint8_t *buffer;
 
-	if (driver_data->midi_in_substream != NULL){
-		spin_lock_irqsave(&driver_data->midi_in_lock, flags);
-		bytes_transmitted = snd_rawmidi_receive(driver_data->midi_in_substream, buffer, message_size);
-		spin_unlock_irqrestore(&driver_data->midi_in_lock, flags);
-	}else{
-		printk(KERN_ALERT "maschine_jam_write_snd_seq_event: no midi_in_substeam to write to.");
+retry:
+	if (output_report->urb != NULL && test_and_set_bit(MJ_OUTPUT_REPORT_URB_IN_FLIGHT, &output_report->urb_flags)){
+		// the completion of the transfer in flight sends the report
+		return 0;
+	}
+	spin_lock_irqsave(output_report->lock, flags);
+	if (!output_report->dirty){
+		spin_unlock_irqrestore(output_report->lock, flags);
+		goto release_urb;
+	}
+	buffer = maschine_jam_hid_output_report_next_buffer(output_report);
+	memcpy(&buffer[MASCHINE_JAM_HID_REPORT_ID_BYTES], output_report->led_state, output_report->size - MASCHINE_JAM_HID_REPORT_ID_BYTES);
+	output_report->dirty = false;
+	output_report->sent_dirty_since = output_report->dirty_since;
+	spin_unlock_irqrestore(output_report->lock, flags);
+	if (output_report->last_sent_valid && memcmp(buffer, output_report->last_sent, output_report->size) == 0){
+		goto release_urb;
+	}
+	if (output_report->urb != NULL){
+		output_report->urb->transfer_buffer = buffer;
+		ret = usb_submit_urb(output_report->urb, GFP_ATOMIC);
+		if (ret != 0){
+			this_cpu_inc(driver_data->stats->led_reports_failed);
+			output_report->last_sent_valid = false;
+			clear_bit(MJ_OUTPUT_REPORT_URB_IN_FLIGHT, &output_report->urb_flags);
+			return ret;
+		}
+		ret = output_report->size;
+	} else {
+		ret = hid_hw_output_report(driver_data->mj_hid_device, buffer, output_report->size);
+		if (ret >= 0){
+			this_cpu_inc(driver_data->stats->led_reports_sent);
+			this_cpu_inc(driver_data->stats->output_latency[maschine_jam_latency_bucket(output_report->sent_dirty_since)]);
+		} else {
+			this_cpu_inc(driver_data->stats->led_reports_failed);
+		}
+	}
+	if (ret >= 0){
+		memcpy(output_report->last_sent, buffer, output_report->size);
+		output_report->last_sent_valid = true;
 	}
-	printk(KERN_NOTICE "maschine_jam_write_snd_seq_event: message_size: %d, bytes_transmitted: %d\n", message_size, bytes_transmitted);
+	return ret;
 
-	return bytes_transmitted;
+release_urb:
+	if (output_report->urb != NULL){
+		clear_bit(MJ_OUTPUT_REPORT_URB_IN_FLIGHT, &output_report->urb_flags);
+		// a sender that found the URB busy meanwhile left its update to us
+		smp_mb__after_atomic();
+		if (READ_ONCE(output_report->dirty)){
+			goto retry;
+		}
+	}
+	return 0;
 }
-static int maschine_jam_write_midi_event(struct maschine_jam_driver_data *driver_data,
-	enum maschine_jam_midi_type midi_type, uint8_t channel, uint8_t key, uint8_t value){
-	struct snd_seq_event event;
+static void maschine_jam_led_frame_request(struct maschine_jam_driver_data *driver_data);
+static void maschine_jam_hid_output_report_complete(struct urb *urb){
+	struct maschine_jam_hid_output_report *output_report = urb->context;
+	struct maschine_jam_driver_data *driver_data = output_report->driver_data;
+	unsigned long flags;
 
-	switch(midi_type){
-		case MJ_MIDI_TYPE_NOTE:
-			printk(KERN_NOTICE "maschine_jam_write_midi_event: noteon: %d %d %d\n", channel, key, value);
-			event.type = SNDRV_SEQ_EVENT_NOTEON;
-			event.data.note.channel = channel;
-			event.data.note.note = key;
-			event.data.note.velocity = value;
-			break;
-		case MJ_MIDI_TYPE_AFTERTOUCH:
-			printk(KERN_NOTICE "maschine_jam_write_midi_event: aftertouch: %d %d %d\n", channel, key, value);
-			event.type = SNDRV_SEQ_EVENT_KEYPRESS;
-			event.data.note.channel = channel;
-			event.data.note.note = key;
-			event.data.note.velocity = value;
-			break;
-		case MJ_MIDI_TYPE_CONTROL_CHANGE:
-			printk(KERN_NOTICE "maschine_jam_write_midi_event: control_change: %d %d %d\n", channel, key, value);
-			event.type = SNDRV_SEQ_EVENT_CONTROLLER;
-			event.data.control.channel = channel;
-			event.data.control.param = key;
-			event.data.control.value = value;
+	switch (urb->status){
+		case 0:
+			output_report->urb_failures = 0;
+			this_cpu_inc(driver_data->stats->led_reports_sent);
+			this_cpu_inc(driver_data->stats->output_latency[maschine_jam_latency_bucket(output_report->sent_dirty_since)]);
 			break;
+		case -ENOENT:
+		case -ECONNRESET:
+		case -ESHUTDOWN:
+			// killed or unplugged, leave the URB idle
+			output_report->last_sent_valid = false;
+			clear_bit(MJ_OUTPUT_REPORT_URB_IN_FLIGHT, &output_report->urb_flags);
+			return;
 		default:
-			printk(KERN_ALERT "maschine_jam_write_midi_event: invalid midi type.\n");
-			return 0;
-			break;
+			printk(KERN_NOTICE "maschine_jam_hid_output_report_complete: report 0x%02X, status %d\n", output_report->report_id, urb->status);
+			this_cpu_inc(driver_data->stats->led_reports_failed);
+			output_report->last_sent_valid = false;
+			output_report->urb_failures++;
+			if (urb->status == -EPIPE || output_report->urb_failures > MASCHINE_JAM_HID_OUTPUT_REPORT_RETRIES){
+				// a retry would fail the same way, leave the URB idle until the next LED change
+				output_report->urb_failures = 0;
+				clear_bit(MJ_OUTPUT_REPORT_URB_IN_FLIGHT, &output_report->urb_flags);
+				return;
+			}
+			// the device did not get this snapshot, send the LED state again with the next frame
+			spin_lock_irqsave(output_report->lock, flags);
+			if (!output_report->dirty){
+				output_report->dirty = true;
+				output_report->dirty_since = output_report->sent_dirty_since;
+			}
+			spin_unlock_irqrestore(output_report->lock, flags);
+			clear_bit(MJ_OUTPUT_REPORT_URB_IN_FLIGHT, &output_report->urb_flags);
+			maschine_jam_led_frame_request(driver_data);
+			return;
+	}
+	clear_bit(MJ_OUTPUT_REPORT_URB_IN_FLIGHT, &output_report->urb_flags);
+	smp_mb__after_atomic();
+	if (READ_ONCE(output_report->dirty)){
+		maschine_jam_hid_send_output_report(driver_data, output_report);
+	}
+}
+// arm the frame timer unless a frame is already pending, cannot block
+static void maschine_jam_led_frame_request(struct maschine_jam_driver_data *driver_data){
+	u64 period_ns;
+	ktime_t next_frame;
+
+	if (test_and_set_bit(MJ_LED_FRAME_ARMED, &driver_data->led_frame_flags)){
+		return;
+	}
+	period_ns = NSEC_PER_SEC / READ_ONCE(driver_data->led_refresh_rate);
+	next_frame = ns_to_ktime(atomic64_read(&driver_data->led_frame_last_ns) + period_ns);
+	hrtimer_start(&driver_data->led_frame_timer, next_frame, HRTIMER_MODE_ABS);
+}
+static enum hrtimer_restart maschine_jam_led_frame_timer_callback(struct hrtimer *timer){
+	struct maschine_jam_driver_data *driver_data = container_of(timer, struct maschine_jam_driver_data, led_frame_timer);
+	int cpu = READ_ONCE(driver_data->led_workqueue_cpu);
+
+	if (cpu != MASCHINE_JAM_LED_WORKQUEUE_CPU_UNPINNED && cpu_online(cpu)){
+		queue_work_on(cpu, driver_data->led_workqueue, &driver_data->led_frame_work);
+	} else {
+		queue_work(driver_data->led_workqueue, &driver_data->led_frame_work);
+	}
+	return HRTIMER_NORESTART;
+}
+static void maschine_jam_led_frame_work(struct work_struct *work){
+	int ret;
+	bool frame_sent = false;
+	struct maschine_jam_driver_data *driver_data = container_of(work, struct maschine_jam_driver_data, led_frame_work);
+
+	atomic64_set(&driver_data->led_frame_last_ns, ktime_get_ns());
+	// LED updates from here on either make it into this frame or request the next one
+	clear_bit(MJ_LED_FRAME_ARMED, &driver_data->led_frame_flags);
+	smp_mb__after_atomic();
+
+	ret = maschine_jam_hid_send_output_report(driver_data, &driver_data->hid_report_led_buttons_output);
+	frame_sent |= ret > 0;
+	ret = maschine_jam_hid_send_output_report(driver_data, &driver_data->hid_report_led_pads_output);
+	frame_sent |= ret > 0;
+	ret = maschine_jam_hid_send_output_report(driver_data, &driver_data->hid_report_led_smartstrips_output);
+	frame_sent |= ret > 0;
+	if (frame_sent){
+		driver_data->led_frames_sent++;
+	}
+}
+
+// Every MIDI message decoded from one HID report is staged in midi_in_staging and handed to
+// the rawmidi substream in a single snd_rawmidi_receive call by maschine_jam_midi_in_flush.
+static void maschine_jam_midi_in_begin(struct maschine_jam_midi_in_staging *staging){
+	staging->length = 0;
+	// Start each block with a full status byte; running status is applied within it.
+	staging->running_status = 0;
+}
+static int maschine_jam_midi_in_flush(struct maschine_jam_driver_data *driver_data){
+	int bytes_transmitted = 0;
+	unsigned long flags;
+
+	if (driver_data->midi_in_staging.length == 0){
+		return 0;
+	}
+	spin_lock_irqsave(&driver_data->midi_in_lock, flags);
+	if (driver_data->midi_in_substream != NULL){
+		bytes_transmitted = snd_rawmidi_receive(driver_data->midi_in_substream, driver_data->midi_in_staging.buffer, driver_data->midi_in_staging.length);
+		if (bytes_transmitted < (int)driver_data->midi_in_staging.length){
+			this_cpu_inc(driver_data->stats->rawmidi_short_writes);
+		}
+	}
+	spin_unlock_irqrestore(&driver_data->midi_in_lock, flags);
+	if (bytes_transmitted > 0){
+		this_cpu_add(driver_data->stats->midi_bytes_in, bytes_transmitted);
 	}
-	return maschine_jam_write_snd_seq_event(driver_data, &event);
+	trace_maschine_jam_rawmidi_receive(driver_data->midi_in_staging.buffer, driver_data->midi_in_staging.length, bytes_transmitted);
+	driver_data->midi_in_staging.length = 0;
+
+	return bytes_transmitted;
 }
-static int maschine_jam_write_sysex_event(struct maschine_jam_driver_data *driver_data, unsigned char* message, uint8_t message_length){
-	struct snd_seq_event event;
+// Append a precompiled channel message, dropping the status byte when it repeats the previous one.
+static int maschine_jam_write_midi_event(struct maschine_jam_midi_in_staging *staging, struct maschine_jam_midi_config *midi_config, uint8_t value){
+	uint8_t status = READ_ONCE(midi_config->status);
+	uint8_t data1 = READ_ONCE(midi_config->data1);
+	uint8_t *buffer = &staging->buffer[staging->length];
+	unsigned int message_size = 0;
+
+	if (status == 0){
+		return 0;
+	}
+	if (staging->length + MASCHINE_JAM_MIDI_MESSAGE_MAX_LENGTH > MASCHINE_JAM_MIDI_IN_BUFFER_BYTES){
+		return 0;
+	}
+	trace_maschine_jam_midi_event(midi_config->type, status & 0x0F, data1, value & 0x7F);
+	if (status != staging->running_status){
+		buffer[message_size++] = status;
+		staging->running_status = status;
+	}
+	buffer[message_size++] = data1;
+	buffer[message_size++] = value & 0x7F;
+	staging->length += message_size;
 
-	printk(KERN_NOTICE "maschine_jam_write_sysex_event: length: %d. message: %02X%02X%02X%02X\n", message_length, message[0], message[1], message[2], message[3]);
-	event.type = SNDRV_SEQ_EVENT_SYSEX;
-	event.flags = 0;
-	event.flags &= ~SNDRV_SEQ_EVENT_LENGTH_MASK;
-	event.flags |= SNDRV_SEQ_EVENT_LENGTH_VARIABLE;
-	event.data.ext.ptr = message;
-	event.data.ext.len = message_length;
+	return message_size;
+}
+static int maschine_jam_write_sysex_event(struct maschine_jam_midi_in_staging *staging, const unsigned char* message, uint8_t message_length){
+	if (staging->length + message_length > MASCHINE_JAM_MIDI_IN_BUFFER_BYTES){
+		return 0;
+	}
+	memcpy(&staging->buffer[staging->length], message, message_length);
+	staging->length += message_length;
+	// A system exclusive message cancels running status.
+	staging->running_status = 0;
 
-	return maschine_jam_write_snd_seq_event(driver_data, &event);
+	return message_length;
 }
 
 static inline uint8_t maschine_jam_get_knob_nibble(u8 *data, uint8_t offset){
@@ -539,7 +1082,27 @@ static inline void maschine_jam_clear_button_bit(u8 *data, uint8_t offset){
 static inline void maschine_jam_toggle_button_bit(u8 *data, uint8_t offset){
 	change_bit(offset % 8, (long unsigned int*)&data[offset / 8]);
 }
-static int maschine_jam_process_report01_knobs_data(struct maschine_jam_driver_data *driver_data, u8 *data){
+#define MASCHINE_JAM_BUTTON_BITMAP_LONGS BITS_TO_LONGS(MASCHINE_JAM_NUMBER_BUTTONS)
+#if BITS_PER_LONG == 64
+#define maschine_jam_le_long_to_cpu(value) le64_to_cpu((__force __le64)(value))
+#else
+#define maschine_jam_le_long_to_cpu(value) le32_to_cpu((__force __le32)(value))
+#endif
+// XOR the cached and incoming button bytes a word at a time into a bitmap where bit n is button n.
+static inline void maschine_jam_get_changed_button_bits(unsigned long *changed_buttons, u8 *old_data, u8 *new_data){
+	unsigned int i, word_bytes;
+	unsigned long old_word, new_word;
+
+	for (i = 0; i < MASCHINE_JAM_BUTTON_BITMAP_LONGS; i++){
+		word_bytes = min_t(unsigned int, sizeof(unsigned long), MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES - (i * sizeof(unsigned long)));
+		old_word = 0;
+		new_word = 0;
+		memcpy(&old_word, &old_data[i * sizeof(unsigned long)], word_bytes);
+		memcpy(&new_word, &new_data[i * sizeof(unsigned long)], word_bytes);
+		changed_buttons[i] = maschine_jam_le_long_to_cpu(old_word ^ new_word);
+	}
+}
+static int maschine_jam_process_report01_knobs_data(struct maschine_jam_inputs *inputs, struct maschine_jam_midi_in_staging *staging, u8 *data){
 	int return_value = 0;
 	unsigned int knob_nibble;
 	uint8_t old_knob_value, new_knob_value;
@@ -548,56 +1111,56 @@ static int maschine_jam_process_report01_knobs_data(struct maschine_jam_driver_d
 	//printk(KERN_ALERT "report - %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X", data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7], data[8], data[9], data[10], data[11], data[12], data[13], data[14], data[15]);
 
 	for (knob_nibble = 0; knob_nibble < MASCHINE_JAM_NUMBER_KNOBS; knob_nibble++){
-		old_knob_value = maschine_jam_get_knob_nibble(driver_data->hid_report01_data_knobs, knob_nibble);
+		old_knob_value = maschine_jam_get_knob_nibble(inputs->hid_report01_data_knobs, knob_nibble);
 		new_knob_value = maschine_jam_get_knob_nibble(data, knob_nibble);
 		if (old_knob_value != new_knob_value){
 			//printk(KERN_ALERT "knob_nibble: %d, old value: %d, new value: %d", knob_nibble, old_knob_value, new_knob_value);
-			knob_config = &driver_data->midi_in_knob_configs[knob_nibble];
-			maschine_jam_set_knob_nibble(driver_data->hid_report01_data_knobs, knob_nibble, new_knob_value);
+			knob_config = &inputs->midi_in_knob_configs[knob_nibble];
+			maschine_jam_set_knob_nibble(inputs->hid_report01_data_knobs, knob_nibble, new_knob_value);
 			return_value = maschine_jam_write_midi_event(
-				driver_data,
-				knob_config->type,
-				knob_config->channel,
-				knob_config->key,
+				staging,
+				knob_config,
 				new_knob_value == (old_knob_value+1) % 0x10 ? 1 : 0
 			);
 		}
 	}
 	return return_value;
 }
-static int maschine_jam_process_report01_buttons_data(struct maschine_jam_driver_data *driver_data, u8 *data){
+#define MASCHINE_JAM_SHIFT_BUTTON 105
+static int maschine_jam_write_shift_event(struct maschine_jam_midi_in_staging *staging, uint8_t value){
+	unsigned char shift_message[] = { 0xf0, 0x00, 0x21, 0x09, 0x15, 0x00, 0x4d, 0x50, 0x00, 0x01, 0x4d, 0x00, 0xf7 };
+
+	shift_message[11] |= value;
+	return maschine_jam_write_sysex_event(
+		staging,
+		shift_message,
+		sizeof(shift_message)
+	);
+}
+static int maschine_jam_process_report01_buttons_data(struct maschine_jam_inputs *inputs, struct maschine_jam_midi_in_staging *staging, u8 *data){
 	int return_value = 0;
 	unsigned int button_bit;
-	uint8_t old_button_value, new_button_value;
+	uint8_t new_button_value;
+	unsigned long changed_buttons[MASCHINE_JAM_BUTTON_BITMAP_LONGS];
 	struct maschine_jam_midi_config *button_config;
-	unsigned char shift_message[] = { 0xf0, 0x00, 0x21, 0x09, 0x15, 0x00, 0x4d, 0x50, 0x00, 0x01, 0x4d, 0x00, 0xf7 };
 
 	//printk(KERN_ALERT "report - %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X", data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7], data[8], data[9], data[10], data[11], data[12], data[13], data[14], data[15]);
 
-	for (button_bit = 0; button_bit < MASCHINE_JAM_NUMBER_BUTTONS; button_bit++){
-		old_button_value = maschine_jam_get_button_bit(driver_data->hid_report01_data_buttons, button_bit);
+	maschine_jam_get_changed_button_bits(changed_buttons, inputs->hid_report01_data_buttons, data);
+	for_each_set_bit(button_bit, changed_buttons, MASCHINE_JAM_NUMBER_BUTTONS){
 		new_button_value = maschine_jam_get_button_bit(data, button_bit);
-		if (old_button_value != new_button_value){
-			//printk(KERN_ALERT "button_bit: %d, old value: %d, new value: %d", button_bit, old_button_value, new_button_value);
-			button_config = &driver_data->midi_in_button_configs[button_bit];
-			maschine_jam_toggle_button_bit(driver_data->hid_report01_data_buttons, button_bit);
-			if (button_bit == 105){
-				shift_message[11] |= new_button_value;
-				return_value = maschine_jam_write_sysex_event(
-					driver_data,
-					shift_message,
-					sizeof(shift_message)
-				);
-			}
-			return_value |= maschine_jam_write_midi_event(
-				driver_data,
-				button_config->type,
-				button_config->channel,
-				button_config->key,
-				button_config->value_max * new_button_value
-			);
+		//printk(KERN_ALERT "button_bit: %d, new value: %d", button_bit, new_button_value);
+		button_config = &inputs->midi_in_button_configs[button_bit];
+		if (button_bit == MASCHINE_JAM_SHIFT_BUTTON){
+			return_value = maschine_jam_write_shift_event(staging, new_button_value);
 		}
+		return_value |= maschine_jam_write_midi_event(
+			staging,
+			button_config,
+			button_config->value_max * new_button_value
+		);
 	}
+	memcpy(inputs->hid_report01_data_buttons, data, MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES);
 	return return_value;
 }
 struct maschine_jam_smartstrip {
@@ -627,7 +1190,7 @@ static inline void maschine_jam_set_smartstrip_touch_value(u8 *data, uint8_t ind
 	smartstrip_value_data[0] = value & 0xFF;
 	smartstrip_value_data[1] = value >> 8;
 }
-static int maschine_jam_process_report02_smartstrips_data(struct maschine_jam_driver_data *driver_data, u8 *data){
+static int maschine_jam_process_report02_smartstrips_data(struct maschine_jam_inputs *inputs, struct maschine_jam_midi_in_staging *staging, u8 *data){
 	int return_value = 0;
 	unsigned int smartstrip_index, touch_index, smartstrip_data_is_dirty;
 	struct maschine_jam_smartstrip old_smartstrip, new_smartstrip;
@@ -639,7 +1202,7 @@ static int maschine_jam_process_report02_smartstrips_data(struct maschine_jam_dr
 	//data[32], data[33], data[34], data[35], data[36], data[37], data[38], data[39], data[40], data[41], data[42], data[43], data[44], data[45], data[46], data[47]);
 
 	for (smartstrip_index = 0; smartstrip_index < MASCHINE_JAM_NUMBER_SMARTSTRIPS; smartstrip_index++){
-		old_smartstrip = maschine_jam_get_smartstrip(driver_data->hid_report02_data_smartstrips, smartstrip_index);
+		old_smartstrip = maschine_jam_get_smartstrip(inputs->hid_report02_data_smartstrips, smartstrip_index);
 		new_smartstrip = maschine_jam_get_smartstrip(data, smartstrip_index);
 		smartstrip_data_is_dirty = (old_smartstrip.timestamp != new_smartstrip.timestamp);
 		for (touch_index = 0; touch_index < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS; touch_index++){
@@ -648,22 +1211,18 @@ static int maschine_jam_process_report02_smartstrips_data(struct maschine_jam_dr
 				//printk(KERN_ALERT "new_smartstrip: smartstrip_index: %d, timestamp: %04X, touch_value[0] %04X, touch_value[1] %04X", smartstrip_index, new_smartstrip.timestamp, new_smartstrip.touch_value[0], new_smartstrip.touch_value[1]);
 				smartstrip_data_is_dirty = 1;
 				if (old_smartstrip.touch_value[touch_index] == 0 || new_smartstrip.touch_value[touch_index] == 0){
-					smartstrip_config = &driver_data->midi_in_smartstrip_configs[smartstrip_index][touch_index][MJ_SMARTSTRIP_FINGER_MODE_TOUCH];
+					smartstrip_config = &inputs->midi_in_smartstrip_configs[smartstrip_index][touch_index][MJ_SMARTSTRIP_FINGER_MODE_TOUCH];
 					maschine_jam_write_midi_event(
-						driver_data,
-						smartstrip_config->type,
-						smartstrip_config->channel,
-						smartstrip_config->key,
+						staging,
+						smartstrip_config,
 						new_smartstrip.touch_value[touch_index] ? 127 : 0
 					);
 				}
 				if (new_smartstrip.touch_value[touch_index] != 0){
-					smartstrip_config = &driver_data->midi_in_smartstrip_configs[smartstrip_index][touch_index][MJ_SMARTSTRIP_FINGER_MODE_SLIDE];
+					smartstrip_config = &inputs->midi_in_smartstrip_configs[smartstrip_index][touch_index][MJ_SMARTSTRIP_FINGER_MODE_SLIDE];
 					maschine_jam_write_midi_event(
-						driver_data,
-						smartstrip_config->type,
-						smartstrip_config->channel,
-						smartstrip_config->key,
+						staging,
+						smartstrip_config,
 						new_smartstrip.touch_value[touch_index] >> 3
 					);
 				}
@@ -671,37 +1230,219 @@ static int maschine_jam_process_report02_smartstrips_data(struct maschine_jam_dr
 		}
 		if (smartstrip_data_is_dirty){
 			// !!! Put inside lock
-			maschine_jam_set_smartstrip(driver_data->hid_report02_data_smartstrips, smartstrip_index, new_smartstrip);
+			maschine_jam_set_smartstrip(inputs->hid_report02_data_smartstrips, smartstrip_index, new_smartstrip);
 		}
 	}
 	return return_value;
 }
 
-static int maschine_jam_raw_event(struct hid_device *mj_hid_device, struct hid_report *report, u8 *data, int size){
-	int return_value = 0;
-	struct maschine_jam_driver_data *driver_data;
+// Translate one validated input report into MIDI bytes in staging. Only the input configs and the
+// cached report state are touched, no ALSA and no locks, so the KUnit suite drives it directly.
+VISIBLE_IF_KUNIT void maschine_jam_translate_input_report(struct maschine_jam_inputs *inputs, struct maschine_jam_midi_in_staging *staging, uint8_t *data){
+	maschine_jam_midi_in_begin(staging);
+	if (data[0] == 0x01){
+		// !!! Validate report
+		// smartstrip_index < smartstrips_hid_field->report_count == MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS
+		maschine_jam_process_report01_knobs_data(inputs, staging, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES]);
+		maschine_jam_process_report01_buttons_data(inputs, staging, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES]);
+	} else if (data[0] == 0x02){
+		// !!! Validate report
+		// smartstrip_index < smartstrips_hid_field->report_count == MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS
+		maschine_jam_process_report02_smartstrips_data(inputs, staging, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES]);
+	}
+}
+EXPORT_SYMBOL_IF_KUNIT(maschine_jam_translate_input_report);
+// Idle fast path: only the cached report state is updated, no changes are decoded.
+static void maschine_jam_store_input_report(struct maschine_jam_inputs *inputs, uint8_t *data){
+	if (data[0] == 0x01){
+		memcpy(inputs->hid_report01_data_knobs, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES], MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES);
+		memcpy(inputs->hid_report01_data_buttons, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES], MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES);
+	} else if (data[0] == 0x02){
+		memcpy(inputs->hid_report02_data_smartstrips, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES], MASCHINE_JAM_HID_REPORT_02_DATA_BYTES);
+	}
+}
+// Stage the current state of held buttons and touched smartstrips. Knobs are relative encoders
+// and have no state to send. The staging buffer holds the worst case, so nothing is cut off.
+VISIBLE_IF_KUNIT void maschine_jam_stage_resync_midi_in(struct maschine_jam_inputs *inputs, struct maschine_jam_midi_in_staging *staging){
+	unsigned int button_bit, smartstrip_index, touch_index;
+	struct maschine_jam_smartstrip smartstrip;
+	struct maschine_jam_midi_config *midi_config;
 
-	if (mj_hid_device != NULL && report != NULL && data != NULL && report->id == data[0]){
-		driver_data = hid_get_drvdata(mj_hid_device);
-		if (report->id == 0x01 && size == MASCHINE_JAM_HID_REPORT_01_BYTES){
-			// !!! Validate report
-			// smartstrip_index < smartstrips_hid_field->report_count == MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS
-			maschine_jam_process_report01_knobs_data(driver_data, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES]);
-			maschine_jam_process_report01_buttons_data(driver_data, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES]);
-		} else if (report->id == 0x02 && size == MASCHINE_JAM_HID_REPORT_02_BYTES){
-			// !!! Validate report
-			// smartstrip_index < smartstrips_hid_field->report_count == MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS
-			maschine_jam_process_report02_smartstrips_data(driver_data, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES]);
-		} else {
-			printk(KERN_ALERT "maschine_jam_raw_event() - error - report id is unknown or bad data size\n");
+	maschine_jam_midi_in_begin(staging);
+	for (button_bit = 0; button_bit < MASCHINE_JAM_NUMBER_BUTTONS; button_bit++){
+		if (maschine_jam_get_button_bit(inputs->hid_report01_data_buttons, button_bit)){
+			if (button_bit == MASCHINE_JAM_SHIFT_BUTTON){
+				maschine_jam_write_shift_event(staging, 1);
+			}
+			midi_config = &inputs->midi_in_button_configs[button_bit];
+			maschine_jam_write_midi_event(staging, midi_config, midi_config->value_max);
 		}
-	} else {
-		printk(KERN_ALERT "maschine_jam_raw_event() - error - bad parameters\n");
 	}
-	return return_value;
+	for (smartstrip_index = 0; smartstrip_index < MASCHINE_JAM_NUMBER_SMARTSTRIPS; smartstrip_index++){
+		smartstrip = maschine_jam_get_smartstrip(inputs->hid_report02_data_smartstrips, smartstrip_index);
+		for (touch_index = 0; touch_index < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS; touch_index++){
+			if (smartstrip.touch_value[touch_index] != 0){
+				maschine_jam_write_midi_event(staging, &inputs->midi_in_smartstrip_configs[smartstrip_index][touch_index][MJ_SMARTSTRIP_FINGER_MODE_TOUCH], 127);
+				maschine_jam_write_midi_event(staging, &inputs->midi_in_smartstrip_configs[smartstrip_index][touch_index][MJ_SMARTSTRIP_FINGER_MODE_SLIDE], smartstrip.touch_value[touch_index] >> 3);
+			}
+		}
+	}
+}
+EXPORT_SYMBOL_IF_KUNIT(maschine_jam_stage_resync_midi_in);
+static void maschine_jam_resync_midi_in(struct maschine_jam_driver_data *driver_data){
+	maschine_jam_stage_resync_midi_in(&driver_data->inputs, &driver_data->midi_in_staging);
+	maschine_jam_midi_in_flush(driver_data);
 }
+// true if the report differs from the cached state that inputs/state shows. The knob bytes hold
+// only the knob nibbles; the smartstrip timestamps tick on every report and are left out.
+static bool maschine_jam_input_report_changes_state(struct maschine_jam_inputs *inputs, uint8_t *data){
+	unsigned int smartstrip_index, touch_index;
+	struct maschine_jam_smartstrip old_smartstrip, new_smartstrip;
 
-enum maschine_jam_io_attribute_type {
+	if (data[0] == 0x01){
+		return memcmp(inputs->hid_report01_data_knobs, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES], MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES) != 0 ||
+			memcmp(inputs->hid_report01_data_buttons, &data[MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES], MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES) != 0;
+	} else if (data[0] == 0x02){
+		for (smartstrip_index = 0; smartstrip_index < MASCHINE_JAM_NUMBER_SMARTSTRIPS; smartstrip_index++){
+			old_smartstrip = maschine_jam_get_smartstrip(inputs->hid_report02_data_smartstrips, smartstrip_index);
+			new_smartstrip = maschine_jam_get_smartstrip(&data[MASCHINE_JAM_HID_REPORT_ID_BYTES], smartstrip_index);
+			for (touch_index = 0; touch_index < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS; touch_index++){
+				if (old_smartstrip.touch_value[touch_index] != new_smartstrip.touch_value[touch_index]){
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+static void maschine_jam_process_input_record(struct maschine_jam_driver_data *driver_data, struct maschine_jam_input_record *record){
+	int bytes_transmitted;
+	bool state_changed = maschine_jam_input_report_changes_state(&driver_data->inputs, record->data);
+
+	if (!READ_ONCE(driver_data->midi_in_up)){
+		write_seqlock(&driver_data->input_state_lock);
+		maschine_jam_store_input_report(&driver_data->inputs, record->data);
+		write_sequnlock(&driver_data->input_state_lock);
+		if (state_changed){
+			sysfs_notify_dirent(driver_data->inputs_state_dirent);
+		}
+		return;
+	}
+	trace_maschine_jam_input_latency(record->data[0], ktime_to_ns(ktime_sub(ktime_get(), record->timestamp)));
+	// translation only stages MIDI bytes, the flush to ALSA stays outside the lock
+	write_seqlock(&driver_data->input_state_lock);
+	maschine_jam_translate_input_report(&driver_data->inputs, &driver_data->midi_in_staging, record->data);
+	write_sequnlock(&driver_data->input_state_lock);
+	if (state_changed){
+		sysfs_notify_dirent(driver_data->inputs_state_dirent);
+	}
+	bytes_transmitted = maschine_jam_midi_in_flush(driver_data);
+	if (bytes_transmitted > 0){
+		this_cpu_inc(driver_data->stats->input_latency[maschine_jam_latency_bucket(record->timestamp)]);
+	}
+}
+// runs on the input worker, so no report is translated with a partly applied mapping
+static void maschine_jam_midi_in_apply_profile(struct maschine_jam_driver_data *driver_data, struct maschine_jam_profile *profile){
+	memcpy(driver_data->inputs.midi_in_knob_configs, profile->midi_in_knob_configs, sizeof(driver_data->inputs.midi_in_knob_configs));
+	memcpy(driver_data->inputs.midi_in_button_configs, profile->midi_in_button_configs, sizeof(driver_data->inputs.midi_in_button_configs));
+	memcpy(driver_data->inputs.midi_in_smartstrip_configs, profile->midi_in_smartstrip_configs, sizeof(driver_data->inputs.midi_in_smartstrip_configs));
+}
+static void maschine_jam_input_work(struct work_struct *work){
+	struct maschine_jam_driver_data *driver_data = container_of(work, struct maschine_jam_driver_data, input_work);
+	struct maschine_jam_input_record record;
+
+	// test_and_clear_bit is fully ordered, pairs with smp_mb__before_atomic in maschine_jam_profile_apply
+	if (test_and_clear_bit(MJ_MIDI_IN_APPLY_PROFILE, &driver_data->midi_in_flags)){
+		maschine_jam_midi_in_apply_profile(driver_data, READ_ONCE(driver_data->midi_in_pending_profile));
+	}
+	// before the queued reports, so they are decoded against the state that was sent
+	if (test_and_clear_bit(MJ_MIDI_IN_RESYNC, &driver_data->midi_in_flags)){
+		maschine_jam_resync_midi_in(driver_data);
+	}
+	while (kfifo_get(&driver_data->input_ring, &record)){
+		maschine_jam_process_input_record(driver_data, &record);
+	}
+}
+static void maschine_jam_capture_report(struct maschine_jam_driver_data *driver_data, ktime_t timestamp, const u8 *data, int size){
+	uint8_t capture_record[MASCHINE_JAM_CAPTURE_RECORD_MAX_BYTES];
+	struct maschine_jam_capture_header *header = (struct maschine_jam_capture_header *)capture_record;
+	unsigned int length = sizeof(struct maschine_jam_capture_header) + size;
+	unsigned long flags;
+
+	if (!test_bit(MJ_CAPTURE_ENABLED, &driver_data->capture_flags)){
+		return;
+	}
+	if (size <= 0 || size > MASCHINE_JAM_CAPTURE_REPORT_MAX_BYTES){
+		this_cpu_inc(driver_data->stats->capture_dropped);
+		return;
+	}
+	header->timestamp_ns = cpu_to_le64(ktime_to_ns(timestamp));
+	header->size = size;
+	memcpy(&capture_record[sizeof(struct maschine_jam_capture_header)], data, size);
+	spin_lock_irqsave(&driver_data->capture_lock, flags);
+	// the capture may have been stopped since the unlocked check
+	if (test_bit(MJ_CAPTURE_ENABLED, &driver_data->capture_flags)){
+		if (kfifo_avail(&driver_data->capture_ring) >= length){
+			kfifo_in(&driver_data->capture_ring, capture_record, length);
+		} else {
+			// reader is behind, records are never split
+			this_cpu_inc(driver_data->stats->capture_dropped);
+		}
+	}
+	spin_unlock_irqrestore(&driver_data->capture_lock, flags);
+	wake_up_interruptible(&driver_data->capture_wait);
+}
+static int maschine_jam_raw_event(struct hid_device *mj_hid_device, struct hid_report *report, u8 *data, int size){
+	int return_value = 0;
+	struct maschine_jam_driver_data *driver_data;
+	struct maschine_jam_input_record record;
+
+	if (mj_hid_device != NULL && report != NULL && data != NULL && report->id == data[0]){
+		record.timestamp = ktime_get();
+		trace_maschine_jam_raw_report(data, size);
+		driver_data = hid_get_drvdata(mj_hid_device);
+		maschine_jam_capture_report(driver_data, record.timestamp, data, size);
+		if (report->id == 0x01){
+			this_cpu_inc(driver_data->stats->reports_received[MJ_STATS_REPORT_01]);
+		} else if (report->id == 0x02){
+			this_cpu_inc(driver_data->stats->reports_received[MJ_STATS_REPORT_02]);
+		} else {
+			this_cpu_inc(driver_data->stats->reports_received[MJ_STATS_REPORT_UNKNOWN]);
+		}
+		if ((report->id == 0x01 && size == MASCHINE_JAM_HID_REPORT_01_BYTES) || (report->id == 0x02 && size == MASCHINE_JAM_HID_REPORT_02_BYTES)){
+			record.size = size;
+			memcpy(record.data, data, size);
+			if (kfifo_in_spinlocked(&driver_data->input_ring, &record, 1, &driver_data->input_ring_producer_lock) == 0){
+				// worker is behind, drop the newest report
+				this_cpu_inc(driver_data->stats->input_ring_overruns);
+			}
+			queue_work(driver_data->input_workqueue, &driver_data->input_work);
+		} else {
+			if (report->id == 0x01 || report->id == 0x02){
+				this_cpu_inc(driver_data->stats->reports_bad_size);
+			}
+			printk(KERN_ALERT "maschine_jam_raw_event() - error - report id is unknown or bad data size\n");
+		}
+	} else {
+		printk(KERN_ALERT "maschine_jam_raw_event() - error - bad parameters\n");
+	}
+	return return_value;
+}
+// Reports from the device. Replayed reports skip this and go to maschine_jam_raw_event directly.
+static int maschine_jam_hid_raw_event(struct hid_device *mj_hid_device, struct hid_report *report, u8 *data, int size){
+	struct maschine_jam_driver_data *driver_data;
+
+	if (mj_hid_device != NULL){
+		driver_data = hid_get_drvdata(mj_hid_device);
+		if (test_bit(MJ_REPLAY_ACTIVE, &driver_data->capture_flags)){
+			this_cpu_inc(driver_data->stats->replay_live_reports_dropped);
+			return 0;
+		}
+	}
+	return maschine_jam_raw_event(mj_hid_device, report, data, size);
+}
+
+enum maschine_jam_io_attribute_type {
 	IO_ATTRIBUTE_INPUT_KNOB,
 	IO_ATTRIBUTE_INPUT_BUTTON,
 	IO_ATTRIBUTE_INPUT_SMARTSTRIP,
@@ -722,6 +1463,16 @@ struct maschine_jam_io_attribute {
 	uint8_t smartstrip_finger;
 	uint8_t smartstrip_finger_mode;
 };
+static struct maschine_jam_midi_config *maschine_jam_inputs_get_midi_config(struct maschine_jam_driver_data *driver_data, struct maschine_jam_io_attribute *io_attribute){
+	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
+		return &driver_data->inputs.midi_in_knob_configs[io_attribute->io_index];
+	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
+		return &driver_data->inputs.midi_in_button_configs[io_attribute->io_index];
+	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
+		return &driver_data->inputs.midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode];
+	}
+	return NULL;
+}
 static ssize_t maschine_jam_inputs_type_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
 	struct kobject *maschine_jam_inputs_button_dir = kobj;
 	struct kobject *maschine_jam_inputs_dir = maschine_jam_inputs_button_dir->parent;
@@ -733,11 +1484,11 @@ static ssize_t maschine_jam_inputs_type_show(struct kobject *kobj, struct kobj_a
 	enum maschine_jam_midi_type midi_type;
 
 	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		midi_type = driver_data->midi_in_knob_configs[io_attribute->io_index].type;
+		midi_type = driver_data->inputs.midi_in_knob_configs[io_attribute->io_index].type;
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
-		midi_type = driver_data->midi_in_button_configs[io_attribute->io_index].type;
+		midi_type = driver_data->inputs.midi_in_button_configs[io_attribute->io_index].type;
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		midi_type = driver_data->midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].type;
+		midi_type = driver_data->inputs.midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].type;
 	} else {
 		return scnprintf(buf, PAGE_SIZE, "unknown attribute type\n");
 	}
@@ -760,6 +1511,7 @@ static ssize_t maschine_jam_inputs_type_store(struct kobject *kobj, struct kobj_
 	struct hid_device *hdev = container_of(dev, struct hid_device, dev);
 	struct maschine_jam_driver_data *driver_data = hid_get_drvdata(hdev);
 	struct maschine_jam_io_attribute *io_attribute = container_of(attr, struct maschine_jam_io_attribute, type_attribute);
+	struct maschine_jam_midi_config *midi_config;
 	enum maschine_jam_midi_type midi_type;
 
 	if (strncmp(buf, MJ_MIDI_TYPE_NOTE_STRING, sizeof(MJ_MIDI_TYPE_NOTE_STRING)) == 0){
@@ -772,12 +1524,10 @@ static ssize_t maschine_jam_inputs_type_store(struct kobject *kobj, struct kobj_
 		printk(KERN_ALERT "maschine_jam_inputs_type_store - invalid type\n");
 		return count;
 	}
-	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		driver_data->midi_in_knob_configs[io_attribute->io_index].type = midi_type;
-	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
-		driver_data->midi_in_button_configs[io_attribute->io_index].type = midi_type;
-	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		driver_data->midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].type = midi_type;
+	midi_config = maschine_jam_inputs_get_midi_config(driver_data, io_attribute);
+	if (midi_config != NULL){
+		midi_config->type = midi_type;
+		maschine_jam_midi_config_compile(midi_config);
 	}
 	return count;
 }
@@ -791,11 +1541,11 @@ static ssize_t maschine_jam_inputs_channel_show(struct kobject *kobj, struct kob
 	struct maschine_jam_io_attribute *io_attribute = container_of(attr, struct maschine_jam_io_attribute, channel_attribute);
 
 	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->midi_in_knob_configs[io_attribute->io_index].channel);
+		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->inputs.midi_in_knob_configs[io_attribute->io_index].channel);
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->midi_in_button_configs[io_attribute->io_index].channel);
+		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->inputs.midi_in_button_configs[io_attribute->io_index].channel);
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].channel);
+		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->inputs.midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].channel);
 	} else {
 		return scnprintf(buf, PAGE_SIZE, "unknown attribute type\n");
 	}
@@ -809,14 +1559,13 @@ static ssize_t maschine_jam_inputs_channel_store(struct kobject *kobj, struct ko
 	struct hid_device *hdev = container_of(dev, struct hid_device, dev);
 	struct maschine_jam_driver_data *driver_data = hid_get_drvdata(hdev);
 	struct maschine_jam_io_attribute *io_attribute = container_of(attr, struct maschine_jam_io_attribute, channel_attribute);
+	struct maschine_jam_midi_config *midi_config;
 
 	sscanf(buf, "%u", &store_value);
-	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		driver_data->midi_in_knob_configs[io_attribute->io_index].channel = store_value & 0xF;
-	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
-		driver_data->midi_in_button_configs[io_attribute->io_index].channel = store_value & 0xF;
-	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		driver_data->midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].channel = store_value & 0xF;
+	midi_config = maschine_jam_inputs_get_midi_config(driver_data, io_attribute);
+	if (midi_config != NULL){
+		midi_config->channel = store_value & 0xF;
+		maschine_jam_midi_config_compile(midi_config);
 	}
 	return count;
 }
@@ -830,11 +1579,11 @@ static ssize_t maschine_jam_inputs_key_show(struct kobject *kobj, struct kobj_at
 	struct maschine_jam_io_attribute *io_attribute = container_of(attr, struct maschine_jam_io_attribute, key_attribute);
 
 	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->midi_in_knob_configs[io_attribute->io_index].key);
+		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->inputs.midi_in_knob_configs[io_attribute->io_index].key);
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->midi_in_button_configs[io_attribute->io_index].key);
+		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->inputs.midi_in_button_configs[io_attribute->io_index].key);
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].key);
+		return scnprintf(buf, PAGE_SIZE, "%d\n", driver_data->inputs.midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].key);
 	} else {
 		return scnprintf(buf, PAGE_SIZE, "unknown attribute type\n");
 	}
@@ -848,14 +1597,13 @@ static ssize_t maschine_jam_inputs_key_store(struct kobject *kobj, struct kobj_a
 	struct hid_device *hdev = container_of(dev, struct hid_device, dev);
 	struct maschine_jam_driver_data *driver_data = hid_get_drvdata(hdev);
 	struct maschine_jam_io_attribute *io_attribute = container_of(attr, struct maschine_jam_io_attribute, key_attribute);
+	struct maschine_jam_midi_config *midi_config;
 
 	sscanf(buf, "%u", &store_value);
-	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		driver_data->midi_in_knob_configs[io_attribute->io_index].key = store_value & 0x7F;
-	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
-		driver_data->midi_in_button_configs[io_attribute->io_index].key = store_value & 0x7F;
-	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		driver_data->midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode].key = store_value & 0x7F;
+	midi_config = maschine_jam_inputs_get_midi_config(driver_data, io_attribute);
+	if (midi_config != NULL){
+		midi_config->key = store_value & 0x7F;
+		maschine_jam_midi_config_compile(midi_config);
 	}
 	return count;
 }
@@ -869,11 +1617,11 @@ static ssize_t maschine_jam_inputs_status_show(struct kobject *kobj, struct kobj
 	struct maschine_jam_io_attribute *io_attribute = container_of(attr, struct maschine_jam_io_attribute, status_attribute);
 
 	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_knob_nibble(driver_data->hid_report01_data_knobs, io_attribute->io_index));
+		return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_knob_nibble(driver_data->inputs.hid_report01_data_knobs, io_attribute->io_index));
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_button_bit(driver_data->hid_report01_data_buttons, io_attribute->io_index));
+		return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_button_bit(driver_data->inputs.hid_report01_data_buttons, io_attribute->io_index));
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_smartstrip(driver_data->hid_report02_data_smartstrips, io_attribute->io_index/2).touch_value[io_attribute->io_index % 2]);
+		return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_smartstrip(driver_data->inputs.hid_report02_data_smartstrips, io_attribute->io_index/2).touch_value[io_attribute->io_index % 2]);
 	} else {
 		return scnprintf(buf, PAGE_SIZE, "unknown attribute type\n");
 	}
@@ -889,451 +1637,22 @@ static ssize_t maschine_jam_inputs_status_store(struct kobject *kobj, struct kob
 	struct maschine_jam_io_attribute *io_attribute = container_of(attr, struct maschine_jam_io_attribute, status_attribute);
 
 	sscanf(buf, "%u", &store_value);
+	write_seqlock(&driver_data->input_state_lock);
 	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		maschine_jam_set_knob_nibble(driver_data->hid_report01_data_knobs, io_attribute->io_index, store_value & 0x0F);
+		maschine_jam_set_knob_nibble(driver_data->inputs.hid_report01_data_knobs, io_attribute->io_index, store_value & 0x0F);
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
 		if (store_value == 0){
-			maschine_jam_clear_button_bit(driver_data->hid_report01_data_buttons, io_attribute->io_index);
+			maschine_jam_clear_button_bit(driver_data->inputs.hid_report01_data_buttons, io_attribute->io_index);
 		} else {
-			maschine_jam_set_button_bit(driver_data->hid_report01_data_buttons, io_attribute->io_index);
+			maschine_jam_set_button_bit(driver_data->inputs.hid_report01_data_buttons, io_attribute->io_index);
 		}
 	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		maschine_jam_set_smartstrip_touch_value(driver_data->hid_report02_data_smartstrips, io_attribute->io_index/2, io_attribute->io_index%2, store_value & 0x03FF);
+		maschine_jam_set_smartstrip_touch_value(driver_data->inputs.hid_report02_data_smartstrips, io_attribute->io_index/2, io_attribute->io_index%2, store_value & 0x03FF);
 	}
+	write_sequnlock(&driver_data->input_state_lock);
+	sysfs_notify_dirent(driver_data->inputs_state_dirent);
 	return count;
 }
-#define MJ_INPUTS_KNOB_ATTRIBUTE_GROUP(_name, _index) \
-	struct maschine_jam_io_attribute maschine_jam_inputs_knob_ ## _name ## _attribute = { \
-		.type_attribute = { \
-			.attr = {.name = "type", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_type_show, \
-			.store = maschine_jam_inputs_type_store, \
-		}, \
-		.channel_attribute = { \
-			.attr = {.name = "channel", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_channel_show, \
-			.store = maschine_jam_inputs_channel_store, \
-		}, \
-		.key_attribute = { \
-			.attr = {.name = "key", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_key_show, \
-			.store = maschine_jam_inputs_key_store, \
-		}, \
-		.status_attribute = { \
-			.attr = {.name = "status", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_status_show, \
-			.store = maschine_jam_inputs_status_store, \
-		}, \
-		.io_attribute_type = IO_ATTRIBUTE_INPUT_KNOB, \
-		.io_index = _index, \
-		.smartstrip_finger = 0, \
-		.smartstrip_finger_mode = 0, \
-	}; \
-	static struct attribute *maschine_jam_inputs_knob_ ## _name ## _attributes[] = { \
-		&maschine_jam_inputs_knob_ ## _name ## _attribute.type_attribute.attr, \
-		&maschine_jam_inputs_knob_ ## _name ## _attribute.channel_attribute.attr, \
-		&maschine_jam_inputs_knob_ ## _name ## _attribute.key_attribute.attr, \
-		&maschine_jam_inputs_knob_ ## _name ## _attribute.status_attribute.attr, \
-		NULL \
-	}; \
-	static const struct attribute_group maschine_jam_inputs_knob_ ## _name ## _group = { \
-		.name = #_name, \
-		.attrs = maschine_jam_inputs_knob_ ## _name ## _attributes, \
-	}
-MJ_INPUTS_KNOB_ATTRIBUTE_GROUP(encoder, 0);
-//MJ_INPUTS_KNOB_ATTRIBUTE_GROUP(unknown_knob, 1);
-static const struct attribute_group *maschine_jam_inputs_knobs_groups[] = {
-	&maschine_jam_inputs_knob_encoder_group,
-	//&maschine_jam_inputs_knob_unknown_knob_group,
-	NULL
-};
-#define MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(_name, _index) \
-	struct maschine_jam_io_attribute maschine_jam_inputs_button_ ## _name ## _attribute = { \
-		.type_attribute = { \
-			.attr = {.name = "type", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_type_show, \
-			.store = maschine_jam_inputs_type_store, \
-		}, \
-		.channel_attribute = { \
-			.attr = {.name = "channel", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_channel_show, \
-			.store = maschine_jam_inputs_channel_store, \
-		}, \
-		.key_attribute = { \
-			.attr = {.name = "key", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_key_show, \
-			.store = maschine_jam_inputs_key_store, \
-		}, \
-		.status_attribute = { \
-			.attr = {.name = "status", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_status_show, \
-			.store = maschine_jam_inputs_status_store, \
-		}, \
-		.io_attribute_type = IO_ATTRIBUTE_INPUT_BUTTON, \
-		.io_index = _index, \
-		.smartstrip_finger = 0, \
-		.smartstrip_finger_mode = 0, \
-	}; \
-	static struct attribute *maschine_jam_inputs_button_ ## _name ## _attributes[] = { \
-		&maschine_jam_inputs_button_ ## _name ## _attribute.type_attribute.attr, \
-		&maschine_jam_inputs_button_ ## _name ## _attribute.channel_attribute.attr, \
-		&maschine_jam_inputs_button_ ## _name ## _attribute.key_attribute.attr, \
-		&maschine_jam_inputs_button_ ## _name ## _attribute.status_attribute.attr, \
-		NULL \
-	}; \
-	static const struct attribute_group maschine_jam_inputs_button_ ## _name ## _group = { \
-		.name = #_name, \
-		.attrs = maschine_jam_inputs_button_ ## _name ## _attributes, \
-	}
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(song, 0);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(scene_1, 1);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(scene_2, 2);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(scene_3, 3);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(scene_4, 4);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(scene_5, 5);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(scene_6, 6);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(scene_7, 7);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(scene_8, 8);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(step, 9);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(pad_mode, 10);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(clear, 11);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(duplicate, 12);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(navigate_up, 13);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(navigate_left, 14);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(navigate_right, 15);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(navigate_down, 16);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(note_repeat, 17);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_1x1, 18);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_1x2, 19);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_1x3, 20);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_1x4, 21);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_1x5, 22);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_1x6, 23);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_1x7, 24);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_1x8, 25);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_2x1, 26);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_2x2, 27);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_2x3, 28);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_2x4, 29);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_2x5, 30);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_2x6, 31);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_2x7, 32);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_2x8, 33);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_3x1, 34);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_3x2, 35);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_3x3, 36);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_3x4, 37);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_3x5, 38);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_3x6, 39);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_3x7, 40);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_3x8, 41);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_4x1, 42);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_4x2, 43);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_4x3, 44);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_4x4, 45);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_4x5, 46);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_4x6, 47);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_4x7, 48);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_4x8, 49);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_5x1, 50);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_5x2, 51);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_5x3, 52);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_5x4, 53);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_5x5, 54);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_5x6, 55);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_5x7, 56);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_5x8, 57);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_6x1, 58);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_6x2, 59);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_6x3, 60);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_6x4, 61);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_6x5, 62);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_6x6, 63);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_6x7, 64);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_6x8, 65);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_7x1, 66);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_7x2, 67);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_7x3, 68);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_7x4, 69);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_7x5, 70);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_7x6, 71);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_7x7, 72);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_7x8, 73);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_8x1, 74);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_8x2, 75);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_8x3, 76);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_8x4, 77);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_8x5, 78);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_8x6, 79);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_8x7, 80);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(matrix_8x8, 81);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(group_a, 82);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(group_b, 83);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(group_c, 84);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(group_d, 85);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(group_e, 86);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(group_f, 87);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(group_g, 88);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(group_h, 89);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(mst, 90);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(grp, 91);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(in_1, 92);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(cue, 93);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(browse, 94);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(macro, 95);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(level, 96);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(aux, 97);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(control, 98);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(auto, 99);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(perform, 100);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(notes, 101);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(lock, 102);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(tune, 103);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(swing, 104);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(shift, 105);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(play, 106);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(rec, 107);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(page_left, 108);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(page_right, 109);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(tempo, 110);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(grid, 111);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(solo, 112);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(mute, 113);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(select, 114);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(encoder_touch, 115);
-MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(encoder_push, 116);
-//MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(unknown_117, 117); // footswitch/line-in?
-//MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(unknown_118, 118);
-//MJ_INPUTS_BUTTON_ATTRIBUTE_GROUP(unknown_119, 119);
-
-static const struct attribute_group *maschine_jam_inputs_buttons_groups[] = {
-	&maschine_jam_inputs_button_song_group,
-	&maschine_jam_inputs_button_scene_1_group,
-	&maschine_jam_inputs_button_scene_2_group,
-	&maschine_jam_inputs_button_scene_3_group,
-	&maschine_jam_inputs_button_scene_4_group,
-	&maschine_jam_inputs_button_scene_5_group,
-	&maschine_jam_inputs_button_scene_6_group,
-	&maschine_jam_inputs_button_scene_7_group,
-	&maschine_jam_inputs_button_scene_8_group,
-	&maschine_jam_inputs_button_step_group,
-	&maschine_jam_inputs_button_pad_mode_group,
-	&maschine_jam_inputs_button_clear_group,
-	&maschine_jam_inputs_button_duplicate_group,
-	&maschine_jam_inputs_button_navigate_up_group,
-	&maschine_jam_inputs_button_navigate_left_group,
-	&maschine_jam_inputs_button_navigate_right_group,
-	&maschine_jam_inputs_button_navigate_down_group,
-	&maschine_jam_inputs_button_note_repeat_group,
-	&maschine_jam_inputs_button_matrix_1x1_group,
-	&maschine_jam_inputs_button_matrix_1x2_group,
-	&maschine_jam_inputs_button_matrix_1x3_group,
-	&maschine_jam_inputs_button_matrix_1x4_group,
-	&maschine_jam_inputs_button_matrix_1x5_group,
-	&maschine_jam_inputs_button_matrix_1x6_group,
-	&maschine_jam_inputs_button_matrix_1x7_group,
-	&maschine_jam_inputs_button_matrix_1x8_group,
-	&maschine_jam_inputs_button_matrix_2x1_group,
-	&maschine_jam_inputs_button_matrix_2x2_group,
-	&maschine_jam_inputs_button_matrix_2x3_group,
-	&maschine_jam_inputs_button_matrix_2x4_group,
-	&maschine_jam_inputs_button_matrix_2x5_group,
-	&maschine_jam_inputs_button_matrix_2x6_group,
-	&maschine_jam_inputs_button_matrix_2x7_group,
-	&maschine_jam_inputs_button_matrix_2x8_group,
-	&maschine_jam_inputs_button_matrix_3x1_group,
-	&maschine_jam_inputs_button_matrix_3x2_group,
-	&maschine_jam_inputs_button_matrix_3x3_group,
-	&maschine_jam_inputs_button_matrix_3x4_group,
-	&maschine_jam_inputs_button_matrix_3x5_group,
-	&maschine_jam_inputs_button_matrix_3x6_group,
-	&maschine_jam_inputs_button_matrix_3x7_group,
-	&maschine_jam_inputs_button_matrix_3x8_group,
-	&maschine_jam_inputs_button_matrix_4x1_group,
-	&maschine_jam_inputs_button_matrix_4x2_group,
-	&maschine_jam_inputs_button_matrix_4x3_group,
-	&maschine_jam_inputs_button_matrix_4x4_group,
-	&maschine_jam_inputs_button_matrix_4x5_group,
-	&maschine_jam_inputs_button_matrix_4x6_group,
-	&maschine_jam_inputs_button_matrix_4x7_group,
-	&maschine_jam_inputs_button_matrix_4x8_group,
-	&maschine_jam_inputs_button_matrix_5x1_group,
-	&maschine_jam_inputs_button_matrix_5x2_group,
-	&maschine_jam_inputs_button_matrix_5x3_group,
-	&maschine_jam_inputs_button_matrix_5x4_group,
-	&maschine_jam_inputs_button_matrix_5x5_group,
-	&maschine_jam_inputs_button_matrix_5x6_group,
-	&maschine_jam_inputs_button_matrix_5x7_group,
-	&maschine_jam_inputs_button_matrix_5x8_group,
-	&maschine_jam_inputs_button_matrix_6x1_group,
-	&maschine_jam_inputs_button_matrix_6x2_group,
-	&maschine_jam_inputs_button_matrix_6x3_group,
-	&maschine_jam_inputs_button_matrix_6x4_group,
-	&maschine_jam_inputs_button_matrix_6x5_group,
-	&maschine_jam_inputs_button_matrix_6x6_group,
-	&maschine_jam_inputs_button_matrix_6x7_group,
-	&maschine_jam_inputs_button_matrix_6x8_group,
-	&maschine_jam_inputs_button_matrix_7x1_group,
-	&maschine_jam_inputs_button_matrix_7x2_group,
-	&maschine_jam_inputs_button_matrix_7x3_group,
-	&maschine_jam_inputs_button_matrix_7x4_group,
-	&maschine_jam_inputs_button_matrix_7x5_group,
-	&maschine_jam_inputs_button_matrix_7x6_group,
-	&maschine_jam_inputs_button_matrix_7x7_group,
-	&maschine_jam_inputs_button_matrix_7x8_group,
-	&maschine_jam_inputs_button_matrix_8x1_group,
-	&maschine_jam_inputs_button_matrix_8x2_group,
-	&maschine_jam_inputs_button_matrix_8x3_group,
-	&maschine_jam_inputs_button_matrix_8x4_group,
-	&maschine_jam_inputs_button_matrix_8x5_group,
-	&maschine_jam_inputs_button_matrix_8x6_group,
-	&maschine_jam_inputs_button_matrix_8x7_group,
-	&maschine_jam_inputs_button_matrix_8x8_group,
-	&maschine_jam_inputs_button_group_a_group,
-	&maschine_jam_inputs_button_group_b_group,
-	&maschine_jam_inputs_button_group_c_group,
-	&maschine_jam_inputs_button_group_d_group,
-	&maschine_jam_inputs_button_group_e_group,
-	&maschine_jam_inputs_button_group_f_group,
-	&maschine_jam_inputs_button_group_g_group,
-	&maschine_jam_inputs_button_group_h_group,
-	&maschine_jam_inputs_button_mst_group,
-	&maschine_jam_inputs_button_grp_group,
-	&maschine_jam_inputs_button_in_1_group,
-	&maschine_jam_inputs_button_cue_group,
-	&maschine_jam_inputs_button_browse_group,
-	&maschine_jam_inputs_button_macro_group,
-	&maschine_jam_inputs_button_level_group,
-	&maschine_jam_inputs_button_aux_group,
-	&maschine_jam_inputs_button_control_group,
-	&maschine_jam_inputs_button_auto_group,
-	&maschine_jam_inputs_button_perform_group,
-	&maschine_jam_inputs_button_notes_group,
-	&maschine_jam_inputs_button_lock_group,
-	&maschine_jam_inputs_button_tune_group,
-	&maschine_jam_inputs_button_swing_group,
-	&maschine_jam_inputs_button_shift_group,
-	&maschine_jam_inputs_button_play_group,
-	&maschine_jam_inputs_button_rec_group,
-	&maschine_jam_inputs_button_page_left_group,
-	&maschine_jam_inputs_button_page_right_group,
-	&maschine_jam_inputs_button_tempo_group,
-	&maschine_jam_inputs_button_grid_group,
-	&maschine_jam_inputs_button_solo_group,
-	&maschine_jam_inputs_button_mute_group,
-	&maschine_jam_inputs_button_select_group,
-	&maschine_jam_inputs_button_encoder_touch_group,
-	&maschine_jam_inputs_button_encoder_push_group,
-	//&maschine_jam_inputs_button_unknown_117_group,
-	//&maschine_jam_inputs_button_unknown_118_group,
-	//&maschine_jam_inputs_button_unknown_119_group,
-	NULL
-};
-#define MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(_name, _index, _smartstrip_finger, _smartstrip_finger_mode) \
-	struct maschine_jam_io_attribute maschine_jam_inputs_smartstrip_ ## _name ## _attribute = { \
-		.type_attribute = { \
-			.attr = {.name = "type", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_type_show, \
-			.store = maschine_jam_inputs_type_store, \
-		}, \
-		.channel_attribute = { \
-			.attr = {.name = "channel", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_channel_show, \
-			.store = maschine_jam_inputs_channel_store, \
-		}, \
-		.key_attribute = { \
-			.attr = {.name = "key", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_key_show, \
-			.store = maschine_jam_inputs_key_store, \
-		}, \
-		.status_attribute = { \
-			.attr = {.name = "status", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_inputs_status_show, \
-			.store = maschine_jam_inputs_status_store, \
-		}, \
-		.io_attribute_type = IO_ATTRIBUTE_INPUT_SMARTSTRIP, \
-		.io_index = _index, \
-		.smartstrip_finger = _smartstrip_finger, \
-		.smartstrip_finger_mode = _smartstrip_finger_mode, \
-	}; \
-	static struct attribute *maschine_jam_inputs_smartstrip_ ## _name ## _attributes[] = { \
-		&maschine_jam_inputs_smartstrip_ ## _name ## _attribute.type_attribute.attr, \
-		&maschine_jam_inputs_smartstrip_ ## _name ## _attribute.channel_attribute.attr, \
-		&maschine_jam_inputs_smartstrip_ ## _name ## _attribute.key_attribute.attr, \
-		&maschine_jam_inputs_smartstrip_ ## _name ## _attribute.status_attribute.attr, \
-		NULL \
-	}; \
-	static const struct attribute_group maschine_jam_inputs_smartstrip_ ## _name ## _group = { \
-		.name = #_name, \
-		.attrs = maschine_jam_inputs_smartstrip_ ## _name ## _attributes, \
-	}
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(1AT, 0, 0, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(1AS, 0, 0, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(1BT, 0, 1, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(1BS, 0, 1, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(2AT, 1, 0, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(2AS, 1, 0, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(2BT, 1, 1, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(2BS, 1, 1, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(3AT, 2, 0, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(3AS, 2, 0, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(3BT, 2, 1, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(3BS, 2, 1, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(4AT, 3, 0, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(4AS, 3, 0, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(4BT, 3, 1, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(4BS, 3, 1, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(5AT, 4, 0, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(5AS, 4, 0, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(5BT, 4, 1, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(5BS, 4, 1, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(6AT, 5, 0, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(6AS, 5, 0, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(6BT, 5, 1, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(6BS, 5, 1, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(7AT, 6, 0, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(7AS, 6, 0, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(7BT, 6, 1, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(7BS, 6, 1, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(8AT, 7, 0, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(8AS, 7, 0, 1);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(8BT, 7, 1, 0);
-MJ_INPUTS_SMARTSTRIP_ATTRIBUTE_GROUP(8BS, 7, 1, 1);
-static const struct attribute_group *maschine_jam_inputs_smartstrips_groups[] = {
-	&maschine_jam_inputs_smartstrip_1AT_group,
-	&maschine_jam_inputs_smartstrip_1AS_group,
-	&maschine_jam_inputs_smartstrip_1BT_group,
-	&maschine_jam_inputs_smartstrip_1BS_group,
-	&maschine_jam_inputs_smartstrip_2AT_group,
-	&maschine_jam_inputs_smartstrip_2AS_group,
-	&maschine_jam_inputs_smartstrip_2BT_group,
-	&maschine_jam_inputs_smartstrip_2BS_group,
-	&maschine_jam_inputs_smartstrip_3AT_group,
-	&maschine_jam_inputs_smartstrip_3AS_group,
-	&maschine_jam_inputs_smartstrip_3BT_group,
-	&maschine_jam_inputs_smartstrip_3BS_group,
-	&maschine_jam_inputs_smartstrip_4AT_group,
-	&maschine_jam_inputs_smartstrip_4AS_group,
-	&maschine_jam_inputs_smartstrip_4BT_group,
-	&maschine_jam_inputs_smartstrip_4BS_group,
-	&maschine_jam_inputs_smartstrip_5AT_group,
-	&maschine_jam_inputs_smartstrip_5AS_group,
-	&maschine_jam_inputs_smartstrip_5BT_group,
-	&maschine_jam_inputs_smartstrip_5BS_group,
-	&maschine_jam_inputs_smartstrip_6AT_group,
-	&maschine_jam_inputs_smartstrip_6AS_group,
-	&maschine_jam_inputs_smartstrip_6BT_group,
-	&maschine_jam_inputs_smartstrip_6BS_group,
-	&maschine_jam_inputs_smartstrip_7AT_group,
-	&maschine_jam_inputs_smartstrip_7AS_group,
-	&maschine_jam_inputs_smartstrip_7BT_group,
-	&maschine_jam_inputs_smartstrip_7BS_group,
-	&maschine_jam_inputs_smartstrip_8AT_group,
-	&maschine_jam_inputs_smartstrip_8AS_group,
-	&maschine_jam_inputs_smartstrip_8BT_group,
-	&maschine_jam_inputs_smartstrip_8BS_group,
-	NULL
-};
 
 static ssize_t maschine_jam_outputs_type_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
 	struct kobject *maschine_jam_outputs_type_dir = kobj;
@@ -1398,7 +1717,7 @@ static ssize_t maschine_jam_outputs_type_store(struct kobject *kobj, struct kobj
 		printk(KERN_ALERT "maschine_jam_outputs_channel_store: invalid io_attribute_type\n");
 		return count;
 	}
-	spin_lock(&driver_data->midi_out_mapping_lock);
+	mutex_lock(&driver_data->midi_out_mapping_mutex);
 	if (maschine_jam_output_mapping_get_midi_info(output_node, &midi_event) < 0){
 		printk(KERN_ALERT "maschine_jam_outputs_channel_store: unable to get midi info\n");
 	} else {
@@ -1411,7 +1730,7 @@ static ssize_t maschine_jam_outputs_type_store(struct kobject *kobj, struct kobj
 			maschine_jam_output_mapping_set_midi_info(driver_data, output_node, &midi_event);
 		}
 	}
-	spin_unlock(&driver_data->midi_out_mapping_lock);
+	mutex_unlock(&driver_data->midi_out_mapping_mutex);
 	return count;
 }
 static ssize_t maschine_jam_outputs_channel_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
@@ -1463,7 +1782,7 @@ static ssize_t maschine_jam_outputs_channel_store(struct kobject *kobj, struct k
 		printk(KERN_ALERT "maschine_jam_outputs_channel_store: invalid io_attribute_type\n");
 		return count;
 	}
-	spin_lock(&driver_data->midi_out_mapping_lock);
+	mutex_lock(&driver_data->midi_out_mapping_mutex);
 	if (maschine_jam_output_mapping_get_midi_info(output_node, &midi_event) < 0){
 		printk(KERN_ALERT "maschine_jam_outputs_channel_store: unable to get midi info\n");
 	} else {
@@ -1473,7 +1792,7 @@ static ssize_t maschine_jam_outputs_channel_store(struct kobject *kobj, struct k
 			maschine_jam_output_mapping_set_midi_info(driver_data, output_node, &midi_event);
 		}
 	}
-	spin_unlock(&driver_data->midi_out_mapping_lock);
+	mutex_unlock(&driver_data->midi_out_mapping_mutex);
 	return count;
 }
 static ssize_t maschine_jam_outputs_key_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
@@ -1525,7 +1844,7 @@ static ssize_t maschine_jam_outputs_key_store(struct kobject *kobj, struct kobj_
 		printk(KERN_ALERT "maschine_jam_outputs_key_store: invalid io_attribute_type\n");
 		return count;
 	}
-	spin_lock(&driver_data->midi_out_mapping_lock);
+	mutex_lock(&driver_data->midi_out_mapping_mutex);
 	if (maschine_jam_output_mapping_get_midi_info(output_node, &midi_event) < 0){
 		printk(KERN_ALERT "maschine_jam_outputs_key_store: unable to get midi info\n");
 	} else {
@@ -1535,7 +1854,7 @@ static ssize_t maschine_jam_outputs_key_store(struct kobject *kobj, struct kobj_
 			maschine_jam_output_mapping_set_midi_info(driver_data, output_node, &midi_event);
 		}
 	}
-	spin_unlock(&driver_data->midi_out_mapping_lock);
+	mutex_unlock(&driver_data->midi_out_mapping_mutex);
 	return count;
 }
 static ssize_t maschine_jam_outputs_status_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
@@ -1548,11 +1867,11 @@ static ssize_t maschine_jam_outputs_status_show(struct kobject *kobj, struct kob
 	//struct maschine_jam_io_attribute *io_attribute = container_of(attr, struct maschine_jam_io_attribute, status_attribute);
 
 	//if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		//return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_knob_nibble(driver_data->hid_report01_data_knobs, io_attribute->io_index));
+		//return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_knob_nibble(driver_data->inputs.hid_report01_data_knobs, io_attribute->io_index));
 	//} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
-		//return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_button_bit(driver_data->hid_report01_data_buttons, io_attribute->io_index));
+		//return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_button_bit(driver_data->inputs.hid_report01_data_buttons, io_attribute->io_index));
 	//} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		//return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_smartstrip(driver_data->hid_report02_data_smartstrips, io_attribute->io_index/2).touch_value[io_attribute->io_index % 2]);
+		//return scnprintf(buf, PAGE_SIZE, "%d\n", maschine_jam_get_smartstrip(driver_data->inputs.hid_report02_data_smartstrips, io_attribute->io_index/2).touch_value[io_attribute->io_index % 2]);
 	//} else {
 		//return scnprintf(buf, PAGE_SIZE, "maschine_jam_outputs_status_show: unknown attribute type\n");
 	//}
@@ -1570,590 +1889,495 @@ static ssize_t maschine_jam_outputs_status_store(struct kobject *kobj, struct ko
 
 	//sscanf(buf, "%u", &store_value);
 	//if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
-		//maschine_jam_set_knob_nibble(driver_data->hid_report01_data_knobs, io_attribute->io_index, store_value & 0x0F);
+		//maschine_jam_set_knob_nibble(driver_data->inputs.hid_report01_data_knobs, io_attribute->io_index, store_value & 0x0F);
 	//} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
 		//if (store_value == 0){
-			//maschine_jam_clear_button_bit(driver_data->hid_report01_data_buttons, io_attribute->io_index);
+			//maschine_jam_clear_button_bit(driver_data->inputs.hid_report01_data_buttons, io_attribute->io_index);
 		//} else {
-			//maschine_jam_set_button_bit(driver_data->hid_report01_data_buttons, io_attribute->io_index);
+			//maschine_jam_set_button_bit(driver_data->inputs.hid_report01_data_buttons, io_attribute->io_index);
 		//}
 	//} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
-		//maschine_jam_set_smartstrip_touch_value(driver_data->hid_report02_data_smartstrips, io_attribute->io_index/2, io_attribute->io_index%2, store_value & 0x03FF);
+		//maschine_jam_set_smartstrip_touch_value(driver_data->inputs.hid_report02_data_smartstrips, io_attribute->io_index/2, io_attribute->io_index%2, store_value & 0x03FF);
 	//}
 	//printk(KERN_ALERT "maschine_jam_outputs_status_store - invalid type\n");
 	printk(KERN_ALERT "maschine_jam_outputs_status_store - unimplemented\n");
 	return count;
 }
-#define MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(_name, _index) \
-	struct maschine_jam_io_attribute maschine_jam_outputs_button_led_ ## _name ## _attribute = { \
-		.type_attribute = { \
-			.attr = {.name = "type", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_type_show, \
-			.store = maschine_jam_outputs_type_store, \
-		}, \
-		.channel_attribute = { \
-			.attr = {.name = "channel", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_channel_show, \
-			.store = maschine_jam_outputs_channel_store, \
-		}, \
-		.key_attribute = { \
-			.attr = {.name = "key", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_key_show, \
-			.store = maschine_jam_outputs_key_store, \
-		}, \
-		.status_attribute = { \
-			.attr = {.name = "status", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_status_show, \
-			.store = maschine_jam_outputs_status_store, \
-		}, \
-		.io_attribute_type = IO_ATTRIBUTE_OUTPUT_BUTTON_LED, \
-		.io_index = _index, \
-		.smartstrip_finger = 0, \
-		.smartstrip_finger_mode = 0, \
-	}; \
-	static struct attribute *maschine_jam_outputs_button_led_ ## _name ## _attributes[] = { \
-		&maschine_jam_outputs_button_led_ ## _name ## _attribute.type_attribute.attr, \
-		&maschine_jam_outputs_button_led_ ## _name ## _attribute.channel_attribute.attr, \
-		&maschine_jam_outputs_button_led_ ## _name ## _attribute.key_attribute.attr, \
-		&maschine_jam_outputs_button_led_ ## _name ## _attribute.status_attribute.attr, \
-		NULL \
-	}; \
-	static const struct attribute_group maschine_jam_outputs_button_led_ ## _name ## _group = { \
-		.name = #_name, \
-		.attrs = maschine_jam_outputs_button_led_ ## _name ## _attributes, \
-	}
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(song, 0);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(step, 1);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(pad_mode, 2);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(clear, 3);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(duplicate, 4);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(navigate_up, 5);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(navigate_left, 6);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(navigate_right, 7);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(navigate_down, 8);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(note_repeat, 9);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(mst, 10);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(grp, 11);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(in_1, 12);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(unknown_1, 13);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(cue, 14);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(unknown_2, 15);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(browse, 16);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(macro, 17);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level, 18);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(aux, 19);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(control, 20);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(auto, 21);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(perform, 22);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(notes, 23);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(lock, 24);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(tune, 25);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(swing, 26);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(shift, 27);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(play, 28);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(rec, 29);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(page_left, 30);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(page_right, 31);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(tempo, 32);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(grid, 33);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(solo, 34);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(mute, 35);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(select, 36);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_left_1, 37);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_left_2, 38);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_left_3, 39);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_left_4, 40);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_left_5, 41);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_left_6, 42);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_left_7, 43);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_left_8, 44);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_right_1, 45);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_right_2, 46);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_right_3, 47);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_right_4, 48);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_right_5, 49);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_right_6, 40);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_right_7, 51);
-MJ_OUTPUTS_BUTTON_LED_ATTRIBUTE_GROUP(level_right_8, 52);
-
-static const struct attribute_group *maschine_jam_outputs_button_led_groups[] = {
-	&maschine_jam_outputs_button_led_song_group,
-	&maschine_jam_outputs_button_led_step_group,
-	&maschine_jam_outputs_button_led_pad_mode_group,
-	&maschine_jam_outputs_button_led_clear_group,
-	&maschine_jam_outputs_button_led_duplicate_group,
-	&maschine_jam_outputs_button_led_navigate_up_group,
-	&maschine_jam_outputs_button_led_navigate_left_group,
-	&maschine_jam_outputs_button_led_navigate_right_group,
-	&maschine_jam_outputs_button_led_navigate_down_group,
-	&maschine_jam_outputs_button_led_note_repeat_group,
-	&maschine_jam_outputs_button_led_mst_group,
-	&maschine_jam_outputs_button_led_grp_group,
-	&maschine_jam_outputs_button_led_in_1_group,
-	&maschine_jam_outputs_button_led_unknown_1_group,
-	&maschine_jam_outputs_button_led_cue_group,
-	&maschine_jam_outputs_button_led_unknown_2_group,
-	&maschine_jam_outputs_button_led_browse_group,
-	&maschine_jam_outputs_button_led_macro_group,
-	&maschine_jam_outputs_button_led_level_group,
-	&maschine_jam_outputs_button_led_aux_group,
-	&maschine_jam_outputs_button_led_control_group,
-	&maschine_jam_outputs_button_led_auto_group,
-	&maschine_jam_outputs_button_led_perform_group,
-	&maschine_jam_outputs_button_led_notes_group,
-	&maschine_jam_outputs_button_led_lock_group,
-	&maschine_jam_outputs_button_led_tune_group,
-	&maschine_jam_outputs_button_led_swing_group,
-	&maschine_jam_outputs_button_led_shift_group,
-	&maschine_jam_outputs_button_led_play_group,
-	&maschine_jam_outputs_button_led_rec_group,
-	&maschine_jam_outputs_button_led_page_left_group,
-	&maschine_jam_outputs_button_led_page_right_group,
-	&maschine_jam_outputs_button_led_tempo_group,
-	&maschine_jam_outputs_button_led_grid_group,
-	&maschine_jam_outputs_button_led_solo_group,
-	&maschine_jam_outputs_button_led_mute_group,
-	&maschine_jam_outputs_button_led_select_group,
-	&maschine_jam_outputs_button_led_level_left_1_group,
-	&maschine_jam_outputs_button_led_level_left_2_group,
-	&maschine_jam_outputs_button_led_level_left_3_group,
-	&maschine_jam_outputs_button_led_level_left_4_group,
-	&maschine_jam_outputs_button_led_level_left_5_group,
-	&maschine_jam_outputs_button_led_level_left_6_group,
-	&maschine_jam_outputs_button_led_level_left_7_group,
-	&maschine_jam_outputs_button_led_level_left_8_group,
-	&maschine_jam_outputs_button_led_level_right_1_group,
-	&maschine_jam_outputs_button_led_level_right_2_group,
-	&maschine_jam_outputs_button_led_level_right_3_group,
-	&maschine_jam_outputs_button_led_level_right_4_group,
-	&maschine_jam_outputs_button_led_level_right_5_group,
-	&maschine_jam_outputs_button_led_level_right_6_group,
-	&maschine_jam_outputs_button_led_level_right_7_group,
-	&maschine_jam_outputs_button_led_level_right_8_group,
-	NULL
-};
 
-#define MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(_name, _index) \
-	struct maschine_jam_io_attribute maschine_jam_outputs_pad_led_ ## _name ## _attribute = { \
-		.type_attribute = { \
-			.attr = {.name = "type", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_type_show, \
-			.store = maschine_jam_outputs_type_store, \
-		}, \
-		.channel_attribute = { \
-			.attr = {.name = "channel", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_channel_show, \
-			.store = maschine_jam_outputs_channel_store, \
-		}, \
-		.key_attribute = { \
-			.attr = {.name = "key", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_key_show, \
-			.store = maschine_jam_outputs_key_store, \
-		}, \
-		.status_attribute = { \
-			.attr = {.name = "status", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_status_show, \
-			.store = maschine_jam_outputs_status_store, \
-		}, \
-		.io_attribute_type = IO_ATTRIBUTE_OUTPUT_PAD_LED, \
-		.io_index = _index, \
-		.smartstrip_finger = 0, \
-		.smartstrip_finger_mode = 0, \
-	}; \
-	static struct attribute *maschine_jam_outputs_pad_led_ ## _name ## _attributes[] = { \
-		&maschine_jam_outputs_pad_led_ ## _name ## _attribute.type_attribute.attr, \
-		&maschine_jam_outputs_pad_led_ ## _name ## _attribute.channel_attribute.attr, \
-		&maschine_jam_outputs_pad_led_ ## _name ## _attribute.key_attribute.attr, \
-		&maschine_jam_outputs_pad_led_ ## _name ## _attribute.status_attribute.attr, \
-		NULL \
-	}; \
-	static const struct attribute_group maschine_jam_outputs_pad_led_ ## _name ## _group = { \
-		.name = #_name, \
-		.attrs = maschine_jam_outputs_pad_led_ ## _name ## _attributes, \
-	}
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(scene_1, 0);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(scene_2, 1);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(scene_3, 2);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(scene_4, 3);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(scene_5, 4);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(scene_6, 5);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(scene_7, 6);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(scene_8, 7);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_1x1, 8);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_1x2, 9);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_1x3, 10);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_1x4, 11);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_1x5, 12);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_1x6, 13);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_1x7, 14);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_1x8, 15);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_2x1, 16);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_2x2, 17);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_2x3, 18);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_2x4, 19);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_2x5, 20);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_2x6, 21);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_2x7, 22);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_2x8, 23);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_3x1, 24);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_3x2, 25);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_3x3, 26);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_3x4, 27);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_3x5, 28);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_3x6, 29);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_3x7, 30);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_3x8, 31);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_4x1, 32);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_4x2, 33);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_4x3, 34);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_4x4, 35);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_4x5, 36);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_4x6, 37);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_4x7, 38);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_4x8, 39);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_5x1, 40);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_5x2, 41);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_5x3, 42);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_5x4, 43);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_5x5, 44);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_5x6, 45);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_5x7, 46);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_5x8, 47);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_6x1, 48);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_6x2, 49);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_6x3, 50);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_6x4, 51);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_6x5, 52);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_6x6, 53);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_6x7, 54);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_6x8, 55);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_7x1, 56);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_7x2, 57);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_7x3, 58);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_7x4, 59);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_7x5, 60);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_7x6, 61);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_7x7, 62);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_7x8, 63);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_8x1, 64);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_8x2, 65);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_8x3, 66);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_8x4, 67);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_8x5, 68);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_8x6, 69);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_8x7, 70);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(matrix_8x8, 71);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(group_a, 72);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(group_b, 73);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(group_c, 74);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(group_d, 75);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(group_e, 76);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(group_f, 77);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(group_g, 78);
-MJ_OUTPUTS_PAD_LED_ATTRIBUTE_GROUP(group_h, 79);
-
-static const struct attribute_group *maschine_jam_outputs_pad_led_groups[] = {
-	&maschine_jam_outputs_pad_led_scene_1_group,
-	&maschine_jam_outputs_pad_led_scene_2_group,
-	&maschine_jam_outputs_pad_led_scene_3_group,
-	&maschine_jam_outputs_pad_led_scene_4_group,
-	&maschine_jam_outputs_pad_led_scene_5_group,
-	&maschine_jam_outputs_pad_led_scene_6_group,
-	&maschine_jam_outputs_pad_led_scene_7_group,
-	&maschine_jam_outputs_pad_led_scene_8_group,
-	&maschine_jam_outputs_pad_led_matrix_1x1_group,
-	&maschine_jam_outputs_pad_led_matrix_1x2_group,
-	&maschine_jam_outputs_pad_led_matrix_1x3_group,
-	&maschine_jam_outputs_pad_led_matrix_1x4_group,
-	&maschine_jam_outputs_pad_led_matrix_1x5_group,
-	&maschine_jam_outputs_pad_led_matrix_1x6_group,
-	&maschine_jam_outputs_pad_led_matrix_1x7_group,
-	&maschine_jam_outputs_pad_led_matrix_1x8_group,
-	&maschine_jam_outputs_pad_led_matrix_2x1_group,
-	&maschine_jam_outputs_pad_led_matrix_2x2_group,
-	&maschine_jam_outputs_pad_led_matrix_2x3_group,
-	&maschine_jam_outputs_pad_led_matrix_2x4_group,
-	&maschine_jam_outputs_pad_led_matrix_2x5_group,
-	&maschine_jam_outputs_pad_led_matrix_2x6_group,
-	&maschine_jam_outputs_pad_led_matrix_2x7_group,
-	&maschine_jam_outputs_pad_led_matrix_2x8_group,
-	&maschine_jam_outputs_pad_led_matrix_3x1_group,
-	&maschine_jam_outputs_pad_led_matrix_3x2_group,
-	&maschine_jam_outputs_pad_led_matrix_3x3_group,
-	&maschine_jam_outputs_pad_led_matrix_3x4_group,
-	&maschine_jam_outputs_pad_led_matrix_3x5_group,
-	&maschine_jam_outputs_pad_led_matrix_3x6_group,
-	&maschine_jam_outputs_pad_led_matrix_3x7_group,
-	&maschine_jam_outputs_pad_led_matrix_3x8_group,
-	&maschine_jam_outputs_pad_led_matrix_4x1_group,
-	&maschine_jam_outputs_pad_led_matrix_4x2_group,
-	&maschine_jam_outputs_pad_led_matrix_4x3_group,
-	&maschine_jam_outputs_pad_led_matrix_4x4_group,
-	&maschine_jam_outputs_pad_led_matrix_4x5_group,
-	&maschine_jam_outputs_pad_led_matrix_4x6_group,
-	&maschine_jam_outputs_pad_led_matrix_4x7_group,
-	&maschine_jam_outputs_pad_led_matrix_4x8_group,
-	&maschine_jam_outputs_pad_led_matrix_5x1_group,
-	&maschine_jam_outputs_pad_led_matrix_5x2_group,
-	&maschine_jam_outputs_pad_led_matrix_5x3_group,
-	&maschine_jam_outputs_pad_led_matrix_5x4_group,
-	&maschine_jam_outputs_pad_led_matrix_5x5_group,
-	&maschine_jam_outputs_pad_led_matrix_5x6_group,
-	&maschine_jam_outputs_pad_led_matrix_5x7_group,
-	&maschine_jam_outputs_pad_led_matrix_5x8_group,
-	&maschine_jam_outputs_pad_led_matrix_6x1_group,
-	&maschine_jam_outputs_pad_led_matrix_6x2_group,
-	&maschine_jam_outputs_pad_led_matrix_6x3_group,
-	&maschine_jam_outputs_pad_led_matrix_6x4_group,
-	&maschine_jam_outputs_pad_led_matrix_6x5_group,
-	&maschine_jam_outputs_pad_led_matrix_6x6_group,
-	&maschine_jam_outputs_pad_led_matrix_6x7_group,
-	&maschine_jam_outputs_pad_led_matrix_6x8_group,
-	&maschine_jam_outputs_pad_led_matrix_7x1_group,
-	&maschine_jam_outputs_pad_led_matrix_7x2_group,
-	&maschine_jam_outputs_pad_led_matrix_7x3_group,
-	&maschine_jam_outputs_pad_led_matrix_7x4_group,
-	&maschine_jam_outputs_pad_led_matrix_7x5_group,
-	&maschine_jam_outputs_pad_led_matrix_7x6_group,
-	&maschine_jam_outputs_pad_led_matrix_7x7_group,
-	&maschine_jam_outputs_pad_led_matrix_7x8_group,
-	&maschine_jam_outputs_pad_led_matrix_8x1_group,
-	&maschine_jam_outputs_pad_led_matrix_8x2_group,
-	&maschine_jam_outputs_pad_led_matrix_8x3_group,
-	&maschine_jam_outputs_pad_led_matrix_8x4_group,
-	&maschine_jam_outputs_pad_led_matrix_8x5_group,
-	&maschine_jam_outputs_pad_led_matrix_8x6_group,
-	&maschine_jam_outputs_pad_led_matrix_8x7_group,
-	&maschine_jam_outputs_pad_led_matrix_8x8_group,
-	&maschine_jam_outputs_pad_led_group_a_group,
-	&maschine_jam_outputs_pad_led_group_b_group,
-	&maschine_jam_outputs_pad_led_group_c_group,
-	&maschine_jam_outputs_pad_led_group_d_group,
-	&maschine_jam_outputs_pad_led_group_e_group,
-	&maschine_jam_outputs_pad_led_group_f_group,
-	&maschine_jam_outputs_pad_led_group_g_group,
-	&maschine_jam_outputs_pad_led_group_h_group,
-	NULL
+// Every control with a sysfs directory, one row per physical control: name, kind, index in the HID
+// input report and index in its LED report. MJ_CONTROL_NONE marks a control without an input or
+// without an LED. A button or pad row gets a directory under inputs/buttons and one under
+// outputs/button_leds or outputs/pad_leds. A smartstrip input index counts strip, finger and
+// finger mode in the order of midi_in_smartstrip_configs. The HID report also carries knob 1 and
+// buttons 117-119, which have no known control and so no row.
+#define MASCHINE_JAM_CONTROLS(X) \
+	X(encoder, KNOB, 0, MJ_CONTROL_NONE) \
+	X(song, BUTTON, 0, 0) \
+	X(scene_1, PAD, 1, 0) \
+	X(scene_2, PAD, 2, 1) \
+	X(scene_3, PAD, 3, 2) \
+	X(scene_4, PAD, 4, 3) \
+	X(scene_5, PAD, 5, 4) \
+	X(scene_6, PAD, 6, 5) \
+	X(scene_7, PAD, 7, 6) \
+	X(scene_8, PAD, 8, 7) \
+	X(step, BUTTON, 9, 1) \
+	X(pad_mode, BUTTON, 10, 2) \
+	X(clear, BUTTON, 11, 3) \
+	X(duplicate, BUTTON, 12, 4) \
+	X(navigate_up, BUTTON, 13, 5) \
+	X(navigate_left, BUTTON, 14, 6) \
+	X(navigate_right, BUTTON, 15, 7) \
+	X(navigate_down, BUTTON, 16, 8) \
+	X(note_repeat, BUTTON, 17, 9) \
+	X(matrix_1x1, PAD, 18, 8) \
+	X(matrix_1x2, PAD, 19, 9) \
+	X(matrix_1x3, PAD, 20, 10) \
+	X(matrix_1x4, PAD, 21, 11) \
+	X(matrix_1x5, PAD, 22, 12) \
+	X(matrix_1x6, PAD, 23, 13) \
+	X(matrix_1x7, PAD, 24, 14) \
+	X(matrix_1x8, PAD, 25, 15) \
+	X(matrix_2x1, PAD, 26, 16) \
+	X(matrix_2x2, PAD, 27, 17) \
+	X(matrix_2x3, PAD, 28, 18) \
+	X(matrix_2x4, PAD, 29, 19) \
+	X(matrix_2x5, PAD, 30, 20) \
+	X(matrix_2x6, PAD, 31, 21) \
+	X(matrix_2x7, PAD, 32, 22) \
+	X(matrix_2x8, PAD, 33, 23) \
+	X(matrix_3x1, PAD, 34, 24) \
+	X(matrix_3x2, PAD, 35, 25) \
+	X(matrix_3x3, PAD, 36, 26) \
+	X(matrix_3x4, PAD, 37, 27) \
+	X(matrix_3x5, PAD, 38, 28) \
+	X(matrix_3x6, PAD, 39, 29) \
+	X(matrix_3x7, PAD, 40, 30) \
+	X(matrix_3x8, PAD, 41, 31) \
+	X(matrix_4x1, PAD, 42, 32) \
+	X(matrix_4x2, PAD, 43, 33) \
+	X(matrix_4x3, PAD, 44, 34) \
+	X(matrix_4x4, PAD, 45, 35) \
+	X(matrix_4x5, PAD, 46, 36) \
+	X(matrix_4x6, PAD, 47, 37) \
+	X(matrix_4x7, PAD, 48, 38) \
+	X(matrix_4x8, PAD, 49, 39) \
+	X(matrix_5x1, PAD, 50, 40) \
+	X(matrix_5x2, PAD, 51, 41) \
+	X(matrix_5x3, PAD, 52, 42) \
+	X(matrix_5x4, PAD, 53, 43) \
+	X(matrix_5x5, PAD, 54, 44) \
+	X(matrix_5x6, PAD, 55, 45) \
+	X(matrix_5x7, PAD, 56, 46) \
+	X(matrix_5x8, PAD, 57, 47) \
+	X(matrix_6x1, PAD, 58, 48) \
+	X(matrix_6x2, PAD, 59, 49) \
+	X(matrix_6x3, PAD, 60, 50) \
+	X(matrix_6x4, PAD, 61, 51) \
+	X(matrix_6x5, PAD, 62, 52) \
+	X(matrix_6x6, PAD, 63, 53) \
+	X(matrix_6x7, PAD, 64, 54) \
+	X(matrix_6x8, PAD, 65, 55) \
+	X(matrix_7x1, PAD, 66, 56) \
+	X(matrix_7x2, PAD, 67, 57) \
+	X(matrix_7x3, PAD, 68, 58) \
+	X(matrix_7x4, PAD, 69, 59) \
+	X(matrix_7x5, PAD, 70, 60) \
+	X(matrix_7x6, PAD, 71, 61) \
+	X(matrix_7x7, PAD, 72, 62) \
+	X(matrix_7x8, PAD, 73, 63) \
+	X(matrix_8x1, PAD, 74, 64) \
+	X(matrix_8x2, PAD, 75, 65) \
+	X(matrix_8x3, PAD, 76, 66) \
+	X(matrix_8x4, PAD, 77, 67) \
+	X(matrix_8x5, PAD, 78, 68) \
+	X(matrix_8x6, PAD, 79, 69) \
+	X(matrix_8x7, PAD, 80, 70) \
+	X(matrix_8x8, PAD, 81, 71) \
+	X(group_a, PAD, 82, 72) \
+	X(group_b, PAD, 83, 73) \
+	X(group_c, PAD, 84, 74) \
+	X(group_d, PAD, 85, 75) \
+	X(group_e, PAD, 86, 76) \
+	X(group_f, PAD, 87, 77) \
+	X(group_g, PAD, 88, 78) \
+	X(group_h, PAD, 89, 79) \
+	X(mst, BUTTON, 90, 10) \
+	X(grp, BUTTON, 91, 11) \
+	X(in_1, BUTTON, 92, 12) \
+	X(cue, BUTTON, 93, 14) \
+	X(browse, BUTTON, 94, 16) \
+	X(macro, BUTTON, 95, 17) \
+	X(level, BUTTON, 96, 18) \
+	X(aux, BUTTON, 97, 19) \
+	X(control, BUTTON, 98, 20) \
+	X(auto, BUTTON, 99, 21) \
+	X(perform, BUTTON, 100, 22) \
+	X(notes, BUTTON, 101, 23) \
+	X(lock, BUTTON, 102, 24) \
+	X(tune, BUTTON, 103, 25) \
+	X(swing, BUTTON, 104, 26) \
+	X(shift, BUTTON, 105, 27) \
+	X(play, BUTTON, 106, 28) \
+	X(rec, BUTTON, 107, 29) \
+	X(page_left, BUTTON, 108, 30) \
+	X(page_right, BUTTON, 109, 31) \
+	X(tempo, BUTTON, 110, 32) \
+	X(grid, BUTTON, 111, 33) \
+	X(solo, BUTTON, 112, 34) \
+	X(mute, BUTTON, 113, 35) \
+	X(select, BUTTON, 114, 36) \
+	X(encoder_touch, BUTTON, 115, MJ_CONTROL_NONE) \
+	X(encoder_push, BUTTON, 116, MJ_CONTROL_NONE) \
+	X(unknown_1, BUTTON, MJ_CONTROL_NONE, 13) \
+	X(unknown_2, BUTTON, MJ_CONTROL_NONE, 15) \
+	X(level_left_1, BUTTON, MJ_CONTROL_NONE, 37) \
+	X(level_left_2, BUTTON, MJ_CONTROL_NONE, 38) \
+	X(level_left_3, BUTTON, MJ_CONTROL_NONE, 39) \
+	X(level_left_4, BUTTON, MJ_CONTROL_NONE, 40) \
+	X(level_left_5, BUTTON, MJ_CONTROL_NONE, 41) \
+	X(level_left_6, BUTTON, MJ_CONTROL_NONE, 42) \
+	X(level_left_7, BUTTON, MJ_CONTROL_NONE, 43) \
+	X(level_left_8, BUTTON, MJ_CONTROL_NONE, 44) \
+	X(level_right_1, BUTTON, MJ_CONTROL_NONE, 45) \
+	X(level_right_2, BUTTON, MJ_CONTROL_NONE, 46) \
+	X(level_right_3, BUTTON, MJ_CONTROL_NONE, 47) \
+	X(level_right_4, BUTTON, MJ_CONTROL_NONE, 48) \
+	X(level_right_5, BUTTON, MJ_CONTROL_NONE, 49) \
+	X(level_right_6, BUTTON, MJ_CONTROL_NONE, 50) \
+	X(level_right_7, BUTTON, MJ_CONTROL_NONE, 51) \
+	X(level_right_8, BUTTON, MJ_CONTROL_NONE, 52) \
+	X(1AT, SMARTSTRIP, 0, MJ_CONTROL_NONE) \
+	X(1AS, SMARTSTRIP, 1, MJ_CONTROL_NONE) \
+	X(1BT, SMARTSTRIP, 2, MJ_CONTROL_NONE) \
+	X(1BS, SMARTSTRIP, 3, MJ_CONTROL_NONE) \
+	X(2AT, SMARTSTRIP, 4, MJ_CONTROL_NONE) \
+	X(2AS, SMARTSTRIP, 5, MJ_CONTROL_NONE) \
+	X(2BT, SMARTSTRIP, 6, MJ_CONTROL_NONE) \
+	X(2BS, SMARTSTRIP, 7, MJ_CONTROL_NONE) \
+	X(3AT, SMARTSTRIP, 8, MJ_CONTROL_NONE) \
+	X(3AS, SMARTSTRIP, 9, MJ_CONTROL_NONE) \
+	X(3BT, SMARTSTRIP, 10, MJ_CONTROL_NONE) \
+	X(3BS, SMARTSTRIP, 11, MJ_CONTROL_NONE) \
+	X(4AT, SMARTSTRIP, 12, MJ_CONTROL_NONE) \
+	X(4AS, SMARTSTRIP, 13, MJ_CONTROL_NONE) \
+	X(4BT, SMARTSTRIP, 14, MJ_CONTROL_NONE) \
+	X(4BS, SMARTSTRIP, 15, MJ_CONTROL_NONE) \
+	X(5AT, SMARTSTRIP, 16, MJ_CONTROL_NONE) \
+	X(5AS, SMARTSTRIP, 17, MJ_CONTROL_NONE) \
+	X(5BT, SMARTSTRIP, 18, MJ_CONTROL_NONE) \
+	X(5BS, SMARTSTRIP, 19, MJ_CONTROL_NONE) \
+	X(6AT, SMARTSTRIP, 20, MJ_CONTROL_NONE) \
+	X(6AS, SMARTSTRIP, 21, MJ_CONTROL_NONE) \
+	X(6BT, SMARTSTRIP, 22, MJ_CONTROL_NONE) \
+	X(6BS, SMARTSTRIP, 23, MJ_CONTROL_NONE) \
+	X(7AT, SMARTSTRIP, 24, MJ_CONTROL_NONE) \
+	X(7AS, SMARTSTRIP, 25, MJ_CONTROL_NONE) \
+	X(7BT, SMARTSTRIP, 26, MJ_CONTROL_NONE) \
+	X(7BS, SMARTSTRIP, 27, MJ_CONTROL_NONE) \
+	X(8AT, SMARTSTRIP, 28, MJ_CONTROL_NONE) \
+	X(8AS, SMARTSTRIP, 29, MJ_CONTROL_NONE) \
+	X(8BT, SMARTSTRIP, 30, MJ_CONTROL_NONE) \
+	X(8BS, SMARTSTRIP, 31, MJ_CONTROL_NONE) \
+	X(1x01, SMARTSTRIP_LED, MJ_CONTROL_NONE, 0) \
+	X(1x02, SMARTSTRIP_LED, MJ_CONTROL_NONE, 1) \
+	X(1x03, SMARTSTRIP_LED, MJ_CONTROL_NONE, 2) \
+	X(1x04, SMARTSTRIP_LED, MJ_CONTROL_NONE, 3) \
+	X(1x05, SMARTSTRIP_LED, MJ_CONTROL_NONE, 4) \
+	X(1x06, SMARTSTRIP_LED, MJ_CONTROL_NONE, 5) \
+	X(1x07, SMARTSTRIP_LED, MJ_CONTROL_NONE, 6) \
+	X(1x08, SMARTSTRIP_LED, MJ_CONTROL_NONE, 7) \
+	X(1x09, SMARTSTRIP_LED, MJ_CONTROL_NONE, 8) \
+	X(1x10, SMARTSTRIP_LED, MJ_CONTROL_NONE, 9) \
+	X(1x11, SMARTSTRIP_LED, MJ_CONTROL_NONE, 10) \
+	X(2x01, SMARTSTRIP_LED, MJ_CONTROL_NONE, 11) \
+	X(2x02, SMARTSTRIP_LED, MJ_CONTROL_NONE, 12) \
+	X(2x03, SMARTSTRIP_LED, MJ_CONTROL_NONE, 13) \
+	X(2x04, SMARTSTRIP_LED, MJ_CONTROL_NONE, 14) \
+	X(2x05, SMARTSTRIP_LED, MJ_CONTROL_NONE, 15) \
+	X(2x06, SMARTSTRIP_LED, MJ_CONTROL_NONE, 16) \
+	X(2x07, SMARTSTRIP_LED, MJ_CONTROL_NONE, 17) \
+	X(2x08, SMARTSTRIP_LED, MJ_CONTROL_NONE, 18) \
+	X(2x09, SMARTSTRIP_LED, MJ_CONTROL_NONE, 19) \
+	X(2x10, SMARTSTRIP_LED, MJ_CONTROL_NONE, 20) \
+	X(2x11, SMARTSTRIP_LED, MJ_CONTROL_NONE, 21) \
+	X(3x01, SMARTSTRIP_LED, MJ_CONTROL_NONE, 22) \
+	X(3x02, SMARTSTRIP_LED, MJ_CONTROL_NONE, 23) \
+	X(3x03, SMARTSTRIP_LED, MJ_CONTROL_NONE, 24) \
+	X(3x04, SMARTSTRIP_LED, MJ_CONTROL_NONE, 25) \
+	X(3x05, SMARTSTRIP_LED, MJ_CONTROL_NONE, 26) \
+	X(3x06, SMARTSTRIP_LED, MJ_CONTROL_NONE, 27) \
+	X(3x07, SMARTSTRIP_LED, MJ_CONTROL_NONE, 28) \
+	X(3x08, SMARTSTRIP_LED, MJ_CONTROL_NONE, 29) \
+	X(3x09, SMARTSTRIP_LED, MJ_CONTROL_NONE, 30) \
+	X(3x10, SMARTSTRIP_LED, MJ_CONTROL_NONE, 31) \
+	X(3x11, SMARTSTRIP_LED, MJ_CONTROL_NONE, 32) \
+	X(4x01, SMARTSTRIP_LED, MJ_CONTROL_NONE, 33) \
+	X(4x02, SMARTSTRIP_LED, MJ_CONTROL_NONE, 34) \
+	X(4x03, SMARTSTRIP_LED, MJ_CONTROL_NONE, 35) \
+	X(4x04, SMARTSTRIP_LED, MJ_CONTROL_NONE, 36) \
+	X(4x05, SMARTSTRIP_LED, MJ_CONTROL_NONE, 37) \
+	X(4x06, SMARTSTRIP_LED, MJ_CONTROL_NONE, 38) \
+	X(4x07, SMARTSTRIP_LED, MJ_CONTROL_NONE, 39) \
+	X(4x08, SMARTSTRIP_LED, MJ_CONTROL_NONE, 40) \
+	X(4x09, SMARTSTRIP_LED, MJ_CONTROL_NONE, 41) \
+	X(4x10, SMARTSTRIP_LED, MJ_CONTROL_NONE, 42) \
+	X(4x11, SMARTSTRIP_LED, MJ_CONTROL_NONE, 43) \
+	X(5x01, SMARTSTRIP_LED, MJ_CONTROL_NONE, 44) \
+	X(5x02, SMARTSTRIP_LED, MJ_CONTROL_NONE, 45) \
+	X(5x03, SMARTSTRIP_LED, MJ_CONTROL_NONE, 46) \
+	X(5x04, SMARTSTRIP_LED, MJ_CONTROL_NONE, 47) \
+	X(5x05, SMARTSTRIP_LED, MJ_CONTROL_NONE, 48) \
+	X(5x06, SMARTSTRIP_LED, MJ_CONTROL_NONE, 49) \
+	X(5x07, SMARTSTRIP_LED, MJ_CONTROL_NONE, 50) \
+	X(5x08, SMARTSTRIP_LED, MJ_CONTROL_NONE, 51) \
+	X(5x09, SMARTSTRIP_LED, MJ_CONTROL_NONE, 52) \
+	X(5x10, SMARTSTRIP_LED, MJ_CONTROL_NONE, 53) \
+	X(5x11, SMARTSTRIP_LED, MJ_CONTROL_NONE, 54) \
+	X(6x01, SMARTSTRIP_LED, MJ_CONTROL_NONE, 55) \
+	X(6x02, SMARTSTRIP_LED, MJ_CONTROL_NONE, 56) \
+	X(6x03, SMARTSTRIP_LED, MJ_CONTROL_NONE, 57) \
+	X(6x04, SMARTSTRIP_LED, MJ_CONTROL_NONE, 58) \
+	X(6x05, SMARTSTRIP_LED, MJ_CONTROL_NONE, 59) \
+	X(6x06, SMARTSTRIP_LED, MJ_CONTROL_NONE, 60) \
+	X(6x07, SMARTSTRIP_LED, MJ_CONTROL_NONE, 61) \
+	X(6x08, SMARTSTRIP_LED, MJ_CONTROL_NONE, 62) \
+	X(6x09, SMARTSTRIP_LED, MJ_CONTROL_NONE, 63) \
+	X(6x10, SMARTSTRIP_LED, MJ_CONTROL_NONE, 64) \
+	X(6x11, SMARTSTRIP_LED, MJ_CONTROL_NONE, 65) \
+	X(7x01, SMARTSTRIP_LED, MJ_CONTROL_NONE, 66) \
+	X(7x02, SMARTSTRIP_LED, MJ_CONTROL_NONE, 67) \
+	X(7x03, SMARTSTRIP_LED, MJ_CONTROL_NONE, 68) \
+	X(7x04, SMARTSTRIP_LED, MJ_CONTROL_NONE, 69) \
+	X(7x05, SMARTSTRIP_LED, MJ_CONTROL_NONE, 70) \
+	X(7x06, SMARTSTRIP_LED, MJ_CONTROL_NONE, 71) \
+	X(7x07, SMARTSTRIP_LED, MJ_CONTROL_NONE, 72) \
+	X(7x08, SMARTSTRIP_LED, MJ_CONTROL_NONE, 73) \
+	X(7x09, SMARTSTRIP_LED, MJ_CONTROL_NONE, 74) \
+	X(7x10, SMARTSTRIP_LED, MJ_CONTROL_NONE, 75) \
+	X(7x11, SMARTSTRIP_LED, MJ_CONTROL_NONE, 76) \
+	X(8x01, SMARTSTRIP_LED, MJ_CONTROL_NONE, 77) \
+	X(8x02, SMARTSTRIP_LED, MJ_CONTROL_NONE, 78) \
+	X(8x03, SMARTSTRIP_LED, MJ_CONTROL_NONE, 79) \
+	X(8x04, SMARTSTRIP_LED, MJ_CONTROL_NONE, 80) \
+	X(8x05, SMARTSTRIP_LED, MJ_CONTROL_NONE, 81) \
+	X(8x06, SMARTSTRIP_LED, MJ_CONTROL_NONE, 82) \
+	X(8x07, SMARTSTRIP_LED, MJ_CONTROL_NONE, 83) \
+	X(8x08, SMARTSTRIP_LED, MJ_CONTROL_NONE, 84) \
+	X(8x09, SMARTSTRIP_LED, MJ_CONTROL_NONE, 85) \
+	X(8x10, SMARTSTRIP_LED, MJ_CONTROL_NONE, 86) \
+	X(8x11, SMARTSTRIP_LED, MJ_CONTROL_NONE, 87)
+
+#define MJ_CONTROL_NONE 0xFF
+enum maschine_jam_control_kind {
+	MJ_CONTROL_KIND_KNOB,
+	MJ_CONTROL_KIND_BUTTON,
+	MJ_CONTROL_KIND_PAD,
+	MJ_CONTROL_KIND_SMARTSTRIP,
+	MJ_CONTROL_KIND_SMARTSTRIP_LED,
+};
+#define MJ_CONTROL_ID(_name, _kind, _hid_index, _led_index) MJ_CONTROL_ ## _name,
+enum maschine_jam_control_id {
+	MASCHINE_JAM_CONTROLS(MJ_CONTROL_ID)
+	MJ_NUMBER_CONTROLS
 };
+struct maschine_jam_control {
+	const char *name;
+	uint8_t kind;
+	uint8_t hid_index;
+	uint8_t led_index;
+};
+#define MJ_CONTROL_DESCRIPTOR(_name, _kind, _hid_index, _led_index) \
+	[MJ_CONTROL_ ## _name] = { .name = #_name, .kind = MJ_CONTROL_KIND_ ## _kind, .hid_index = _hid_index, .led_index = _led_index },
+static const struct maschine_jam_control maschine_jam_controls[MJ_NUMBER_CONTROLS] = {
+	MASCHINE_JAM_CONTROLS(MJ_CONTROL_DESCRIPTOR)
+};
+// indexed by the io_attribute_type of the controls in the directory
+static const char *maschine_jam_control_directory_paths[MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES] = {
+	[IO_ATTRIBUTE_INPUT_KNOB] = "inputs/knobs",
+	[IO_ATTRIBUTE_INPUT_BUTTON] = "inputs/buttons",
+	[IO_ATTRIBUTE_INPUT_SMARTSTRIP] = "inputs/smartstrips",
+	[IO_ATTRIBUTE_OUTPUT_BUTTON_LED] = "outputs/button_leds",
+	[IO_ATTRIBUTE_OUTPUT_PAD_LED] = "outputs/pad_leds",
+	[IO_ATTRIBUTE_OUTPUT_SMARTSTRIP_LED] = "outputs/smartstrip_leds",
+};
+static const struct maschine_jam_control* maschine_jam_control_find(const char *name){
+	unsigned int i;
 
-#define MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(_name, _index) \
-	struct maschine_jam_io_attribute maschine_jam_outputs_smartstrip_led_ ## _name ## _attribute = { \
-		.type_attribute = { \
-			.attr = {.name = "type", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_type_show, \
-			.store = maschine_jam_outputs_type_store, \
-		}, \
-		.channel_attribute = { \
-			.attr = {.name = "channel", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_channel_show, \
-			.store = maschine_jam_outputs_channel_store, \
-		}, \
-		.key_attribute = { \
-			.attr = {.name = "key", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_key_show, \
-			.store = maschine_jam_outputs_key_store, \
-		}, \
-		.status_attribute = { \
-			.attr = {.name = "status", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS}, \
-			.show = maschine_jam_outputs_status_show, \
-			.store = maschine_jam_outputs_status_store, \
-		}, \
-		.io_attribute_type = IO_ATTRIBUTE_OUTPUT_SMARTSTRIP_LED, \
-		.io_index = _index, \
-		.smartstrip_finger = 0, \
-		.smartstrip_finger_mode = 0, \
-	}; \
-	static struct attribute *maschine_jam_outputs_smartstrip_led_ ## _name ## _attributes[] = { \
-		&maschine_jam_outputs_smartstrip_led_ ## _name ## _attribute.type_attribute.attr, \
-		&maschine_jam_outputs_smartstrip_led_ ## _name ## _attribute.channel_attribute.attr, \
-		&maschine_jam_outputs_smartstrip_led_ ## _name ## _attribute.key_attribute.attr, \
-		&maschine_jam_outputs_smartstrip_led_ ## _name ## _attribute.status_attribute.attr, \
-		NULL \
-	}; \
-	static const struct attribute_group maschine_jam_outputs_smartstrip_led_ ## _name ## _group = { \
-		.name = #_name, \
-		.attrs = maschine_jam_outputs_smartstrip_led_ ## _name ## _attributes, \
-	}
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x01, 0);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x02, 1);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x03, 2);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x04, 3);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x05, 4);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x06, 5);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x07, 6);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x08, 7);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x09, 8);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x10, 9);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(1x11, 10);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x01, 11);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x02, 12);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x03, 13);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x04, 14);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x05, 15);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x06, 16);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x07, 17);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x08, 18);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x09, 19);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x10, 20);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(2x11, 21);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x01, 22);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x02, 23);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x03, 24);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x04, 25);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x05, 26);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x06, 27);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x07, 28);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x08, 29);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x09, 30);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x10, 31);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(3x11, 32);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x01, 33);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x02, 34);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x03, 35);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x04, 36);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x05, 37);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x06, 38);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x07, 39);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x08, 40);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x09, 41);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x10, 42);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(4x11, 43);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x01, 44);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x02, 45);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x03, 46);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x04, 47);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x05, 48);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x06, 49);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x07, 50);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x08, 51);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x09, 52);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x10, 53);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(5x11, 54);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x01, 55);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x02, 56);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x03, 57);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x04, 58);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x05, 59);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x06, 60);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x07, 61);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x08, 62);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x09, 63);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x10, 64);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(6x11, 65);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x01, 66);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x02, 67);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x03, 68);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x04, 69);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x05, 70);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x06, 71);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x07, 72);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x08, 73);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x09, 74);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x10, 75);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(7x11, 76);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x01, 77);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x02, 78);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x03, 79);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x04, 80);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x05, 81);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x06, 82);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x07, 83);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x08, 84);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x09, 85);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x10, 86);
-MJ_OUTPUTS_SMARTSTRIP_LED_ATTRIBUTE_GROUP(8x11, 87);
-
-static const struct attribute_group *maschine_jam_outputs_smartstrip_led_groups[] = {
-	&maschine_jam_outputs_smartstrip_led_1x01_group,
-	&maschine_jam_outputs_smartstrip_led_1x02_group,
-	&maschine_jam_outputs_smartstrip_led_1x03_group,
-	&maschine_jam_outputs_smartstrip_led_1x04_group,
-	&maschine_jam_outputs_smartstrip_led_1x05_group,
-	&maschine_jam_outputs_smartstrip_led_1x06_group,
-	&maschine_jam_outputs_smartstrip_led_1x07_group,
-	&maschine_jam_outputs_smartstrip_led_1x08_group,
-	&maschine_jam_outputs_smartstrip_led_1x09_group,
-	&maschine_jam_outputs_smartstrip_led_1x10_group,
-	&maschine_jam_outputs_smartstrip_led_1x11_group,
-	&maschine_jam_outputs_smartstrip_led_2x01_group,
-	&maschine_jam_outputs_smartstrip_led_2x02_group,
-	&maschine_jam_outputs_smartstrip_led_2x03_group,
-	&maschine_jam_outputs_smartstrip_led_2x04_group,
-	&maschine_jam_outputs_smartstrip_led_2x05_group,
-	&maschine_jam_outputs_smartstrip_led_2x06_group,
-	&maschine_jam_outputs_smartstrip_led_2x07_group,
-	&maschine_jam_outputs_smartstrip_led_2x08_group,
-	&maschine_jam_outputs_smartstrip_led_2x09_group,
-	&maschine_jam_outputs_smartstrip_led_2x10_group,
-	&maschine_jam_outputs_smartstrip_led_2x11_group,
-	&maschine_jam_outputs_smartstrip_led_3x01_group,
-	&maschine_jam_outputs_smartstrip_led_3x02_group,
-	&maschine_jam_outputs_smartstrip_led_3x03_group,
-	&maschine_jam_outputs_smartstrip_led_3x04_group,
-	&maschine_jam_outputs_smartstrip_led_3x05_group,
-	&maschine_jam_outputs_smartstrip_led_3x06_group,
-	&maschine_jam_outputs_smartstrip_led_3x07_group,
-	&maschine_jam_outputs_smartstrip_led_3x08_group,
-	&maschine_jam_outputs_smartstrip_led_3x09_group,
-	&maschine_jam_outputs_smartstrip_led_3x10_group,
-	&maschine_jam_outputs_smartstrip_led_3x11_group,
-	&maschine_jam_outputs_smartstrip_led_4x01_group,
-	&maschine_jam_outputs_smartstrip_led_4x02_group,
-	&maschine_jam_outputs_smartstrip_led_4x03_group,
-	&maschine_jam_outputs_smartstrip_led_4x04_group,
-	&maschine_jam_outputs_smartstrip_led_4x05_group,
-	&maschine_jam_outputs_smartstrip_led_4x06_group,
-	&maschine_jam_outputs_smartstrip_led_4x07_group,
-	&maschine_jam_outputs_smartstrip_led_4x08_group,
-	&maschine_jam_outputs_smartstrip_led_4x09_group,
-	&maschine_jam_outputs_smartstrip_led_4x10_group,
-	&maschine_jam_outputs_smartstrip_led_4x11_group,
-	&maschine_jam_outputs_smartstrip_led_5x01_group,
-	&maschine_jam_outputs_smartstrip_led_5x02_group,
-	&maschine_jam_outputs_smartstrip_led_5x03_group,
-	&maschine_jam_outputs_smartstrip_led_5x04_group,
-	&maschine_jam_outputs_smartstrip_led_5x05_group,
-	&maschine_jam_outputs_smartstrip_led_5x06_group,
-	&maschine_jam_outputs_smartstrip_led_5x07_group,
-	&maschine_jam_outputs_smartstrip_led_5x08_group,
-	&maschine_jam_outputs_smartstrip_led_5x09_group,
-	&maschine_jam_outputs_smartstrip_led_5x10_group,
-	&maschine_jam_outputs_smartstrip_led_5x11_group,
-	&maschine_jam_outputs_smartstrip_led_6x01_group,
-	&maschine_jam_outputs_smartstrip_led_6x02_group,
-	&maschine_jam_outputs_smartstrip_led_6x03_group,
-	&maschine_jam_outputs_smartstrip_led_6x04_group,
-	&maschine_jam_outputs_smartstrip_led_6x05_group,
-	&maschine_jam_outputs_smartstrip_led_6x06_group,
-	&maschine_jam_outputs_smartstrip_led_6x07_group,
-	&maschine_jam_outputs_smartstrip_led_6x08_group,
-	&maschine_jam_outputs_smartstrip_led_6x09_group,
-	&maschine_jam_outputs_smartstrip_led_6x10_group,
-	&maschine_jam_outputs_smartstrip_led_6x11_group,
-	&maschine_jam_outputs_smartstrip_led_7x01_group,
-	&maschine_jam_outputs_smartstrip_led_7x02_group,
-	&maschine_jam_outputs_smartstrip_led_7x03_group,
-	&maschine_jam_outputs_smartstrip_led_7x04_group,
-	&maschine_jam_outputs_smartstrip_led_7x05_group,
-	&maschine_jam_outputs_smartstrip_led_7x06_group,
-	&maschine_jam_outputs_smartstrip_led_7x07_group,
-	&maschine_jam_outputs_smartstrip_led_7x08_group,
-	&maschine_jam_outputs_smartstrip_led_7x09_group,
-	&maschine_jam_outputs_smartstrip_led_7x10_group,
-	&maschine_jam_outputs_smartstrip_led_7x11_group,
-	&maschine_jam_outputs_smartstrip_led_8x01_group,
-	&maschine_jam_outputs_smartstrip_led_8x02_group,
-	&maschine_jam_outputs_smartstrip_led_8x03_group,
-	&maschine_jam_outputs_smartstrip_led_8x04_group,
-	&maschine_jam_outputs_smartstrip_led_8x05_group,
-	&maschine_jam_outputs_smartstrip_led_8x06_group,
-	&maschine_jam_outputs_smartstrip_led_8x07_group,
-	&maschine_jam_outputs_smartstrip_led_8x08_group,
-	&maschine_jam_outputs_smartstrip_led_8x09_group,
-	&maschine_jam_outputs_smartstrip_led_8x10_group,
-	&maschine_jam_outputs_smartstrip_led_8x11_group,
-	NULL
+	for (i = 0; i < MJ_NUMBER_CONTROLS; i++){
+		if (strcmp(maschine_jam_controls[i].name, name) == 0){
+			return &maschine_jam_controls[i];
+		}
+	}
+	return NULL;
+}
+// Fills the io fields of io_attribute for the directory of io_attribute_type, false if the control
+// has no directory there.
+static bool maschine_jam_control_get_io_attribute(const struct maschine_jam_control *control, enum maschine_jam_io_attribute_type io_attribute_type, struct maschine_jam_io_attribute *io_attribute){
+	uint8_t index;
+
+	switch (io_attribute_type){
+		case IO_ATTRIBUTE_INPUT_KNOB:
+			index = control->kind == MJ_CONTROL_KIND_KNOB ? control->hid_index : MJ_CONTROL_NONE;
+			break;
+		case IO_ATTRIBUTE_INPUT_BUTTON:
+			index = control->kind == MJ_CONTROL_KIND_BUTTON || control->kind == MJ_CONTROL_KIND_PAD ? control->hid_index : MJ_CONTROL_NONE;
+			break;
+		case IO_ATTRIBUTE_INPUT_SMARTSTRIP:
+			index = control->kind == MJ_CONTROL_KIND_SMARTSTRIP ? control->hid_index : MJ_CONTROL_NONE;
+			break;
+		case IO_ATTRIBUTE_OUTPUT_BUTTON_LED:
+			index = control->kind == MJ_CONTROL_KIND_BUTTON ? control->led_index : MJ_CONTROL_NONE;
+			break;
+		case IO_ATTRIBUTE_OUTPUT_PAD_LED:
+			index = control->kind == MJ_CONTROL_KIND_PAD ? control->led_index : MJ_CONTROL_NONE;
+			break;
+		case IO_ATTRIBUTE_OUTPUT_SMARTSTRIP_LED:
+			index = control->kind == MJ_CONTROL_KIND_SMARTSTRIP_LED ? control->led_index : MJ_CONTROL_NONE;
+			break;
+		default:
+			index = MJ_CONTROL_NONE;
+			break;
+	}
+	if (index == MJ_CONTROL_NONE){
+		return false;
+	}
+	io_attribute->io_attribute_type = io_attribute_type;
+	io_attribute->io_index = index;
+	io_attribute->smartstrip_finger = 0;
+	io_attribute->smartstrip_finger_mode = 0;
+	if (io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
+		io_attribute->io_index = index / (MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES);
+		io_attribute->smartstrip_finger = (index / MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES) % MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS;
+		io_attribute->smartstrip_finger_mode = index % MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES;
+	}
+	return true;
+}
+
+static const struct maschine_jam_io_attribute maschine_jam_inputs_io_attribute_template = {
+	.type_attribute = {
+		.attr = {.name = "type", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+		.show = maschine_jam_inputs_type_show,
+		.store = maschine_jam_inputs_type_store,
+	},
+	.channel_attribute = {
+		.attr = {.name = "channel", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+		.show = maschine_jam_inputs_channel_show,
+		.store = maschine_jam_inputs_channel_store,
+	},
+	.key_attribute = {
+		.attr = {.name = "key", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+		.show = maschine_jam_inputs_key_show,
+		.store = maschine_jam_inputs_key_store,
+	},
+	.status_attribute = {
+		.attr = {.name = "status", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+		.show = maschine_jam_inputs_status_show,
+		.store = maschine_jam_inputs_status_store,
+	},
+};
+static const struct maschine_jam_io_attribute maschine_jam_outputs_io_attribute_template = {
+	.type_attribute = {
+		.attr = {.name = "type", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+		.show = maschine_jam_outputs_type_show,
+		.store = maschine_jam_outputs_type_store,
+	},
+	.channel_attribute = {
+		.attr = {.name = "channel", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+		.show = maschine_jam_outputs_channel_show,
+		.store = maschine_jam_outputs_channel_store,
+	},
+	.key_attribute = {
+		.attr = {.name = "key", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+		.show = maschine_jam_outputs_key_show,
+		.store = maschine_jam_outputs_key_store,
+	},
+	.status_attribute = {
+		.attr = {.name = "status", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+		.show = maschine_jam_outputs_status_show,
+		.store = maschine_jam_outputs_status_store,
+	},
 };
+// One directory of a control, built at probe from its row and the template of its side.
+struct maschine_jam_control_group {
+	struct maschine_jam_io_attribute io_attribute;
+	struct attribute *attributes[5];
+	struct attribute_group group;
+};
+static int maschine_jam_create_sysfs_control_groups(struct maschine_jam_driver_data *driver_data, struct kobject *directory, enum maschine_jam_io_attribute_type io_attribute_type){
+	int error_code = 0;
+	unsigned int i, number_control_groups = 0;
+	struct maschine_jam_io_attribute io_attribute;
+	struct maschine_jam_control_group *control_groups;
+	struct maschine_jam_control_group *control_group;
+
+	BUILD_BUG_ON(MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES != IO_ATTRIBUTE_OUTPUT_SMARTSTRIP_LED + 1);
+	for (i = 0; i < MJ_NUMBER_CONTROLS; i++){
+		if (maschine_jam_control_get_io_attribute(&maschine_jam_controls[i], io_attribute_type, &io_attribute)){
+			number_control_groups++;
+		}
+	}
+	control_groups = kvcalloc(number_control_groups, sizeof(struct maschine_jam_control_group), GFP_KERNEL);
+	if (control_groups == NULL){
+		return -ENOMEM;
+	}
+	number_control_groups = 0;
+	for (i = 0; i < MJ_NUMBER_CONTROLS; i++){
+		// resolved before a slot is taken, the array only has room for the matching rows
+		if (io_attribute_type <= IO_ATTRIBUTE_INPUT_SMARTSTRIP){
+			io_attribute = maschine_jam_inputs_io_attribute_template;
+		} else {
+			io_attribute = maschine_jam_outputs_io_attribute_template;
+		}
+		if (!maschine_jam_control_get_io_attribute(&maschine_jam_controls[i], io_attribute_type, &io_attribute)){
+			continue;
+		}
+		control_group = &control_groups[number_control_groups];
+		control_group->io_attribute = io_attribute;
+		sysfs_attr_init(&control_group->io_attribute.type_attribute.attr);
+		sysfs_attr_init(&control_group->io_attribute.channel_attribute.attr);
+		sysfs_attr_init(&control_group->io_attribute.key_attribute.attr);
+		sysfs_attr_init(&control_group->io_attribute.status_attribute.attr);
+		control_group->attributes[0] = &control_group->io_attribute.type_attribute.attr;
+		control_group->attributes[1] = &control_group->io_attribute.channel_attribute.attr;
+		control_group->attributes[2] = &control_group->io_attribute.key_attribute.attr;
+		control_group->attributes[3] = &control_group->io_attribute.status_attribute.attr;
+		control_group->attributes[4] = NULL;
+		control_group->group.name = maschine_jam_controls[i].name;
+		control_group->group.attrs = control_group->attributes;
+		error_code = sysfs_create_group(directory, &control_group->group);
+		if (error_code < 0){
+			printk(KERN_ALERT "sysfs_create_group %s/%s failed!\n", maschine_jam_control_directory_paths[io_attribute_type], maschine_jam_controls[i].name);
+			goto failure_remove_control_groups;
+		}
+		number_control_groups++;
+	}
+	driver_data->control_groups[io_attribute_type] = control_groups;
+	driver_data->number_control_groups[io_attribute_type] = number_control_groups;
+	return 0;
+
+failure_remove_control_groups:
+	while (number_control_groups > 0){
+		number_control_groups--;
+		sysfs_remove_group(directory, &control_groups[number_control_groups].group);
+	}
+	kvfree(control_groups);
+	return error_code;
+}
+static void maschine_jam_delete_sysfs_control_groups(struct maschine_jam_driver_data *driver_data, struct kobject *directory, enum maschine_jam_io_attribute_type io_attribute_type){
+	struct maschine_jam_control_group *control_groups = driver_data->control_groups[io_attribute_type];
+	unsigned int i;
+
+	if (control_groups == NULL){
+		return;
+	}
+	for (i = 0; i < driver_data->number_control_groups[io_attribute_type]; i++){
+		sysfs_remove_group(directory, &control_groups[i].group);
+	}
+	kvfree(control_groups);
+	driver_data->control_groups[io_attribute_type] = NULL;
+	driver_data->number_control_groups[io_attribute_type] = 0;
+}
 
 static int maschine_jam_snd_dev_free(struct snd_device *dev){
 	return 0;
@@ -2178,6 +2402,7 @@ static int maschine_jam_midi_in_close(struct snd_rawmidi_substream *substream){
 	printk(KERN_NOTICE "maschine_jam_midi_in_close() - 1\n");
 	spin_lock_irq(&driver_data->midi_in_lock);
 	driver_data->midi_in_substream = NULL;
+	WRITE_ONCE(driver_data->midi_in_up, 0);
 	spin_unlock_irq(&driver_data->midi_in_lock);
 	printk(KERN_NOTICE "maschine_jam_midi_in_close() - 2\n");
 	return 0;
@@ -2185,11 +2410,18 @@ static int maschine_jam_midi_in_close(struct snd_rawmidi_substream *substream){
 
 static void maschine_jam_midi_in_trigger(struct snd_rawmidi_substream *substream, int up){
 	unsigned long flags;
+	bool resync;
 	struct maschine_jam_driver_data *driver_data = substream->rmidi->private_data;
 
 	printk(KERN_NOTICE "maschine_jam_midi_in_trigger() - 1\n");
 	spin_lock_irqsave(&driver_data->midi_in_lock, flags);
-	driver_data->midi_in_up = up;
+	resync = up && !driver_data->midi_in_up && midi_in_resync;
+	// set first, reports the worker takes after the resync have to be decoded
+	WRITE_ONCE(driver_data->midi_in_up, up);
+	if (resync){
+		set_bit(MJ_MIDI_IN_RESYNC, &driver_data->midi_in_flags);
+		queue_work(driver_data->input_workqueue, &driver_data->input_work);
+	}
 	spin_unlock_irqrestore(&driver_data->midi_in_lock, flags);
 	printk(KERN_NOTICE "maschine_jam_midi_in_trigger() - 2\n");
 }
@@ -2273,130 +2505,209 @@ static inline uint8_t maschine_jam_get_smartstrip_led_state(struct maschine_jam_
 	return 0;
 }
 
-static inline void maschine_jam_refresh_hid_report_led_smartstrips(struct maschine_jam_driver_data *driver_data){
+// render the smartstrip display states into report 0x82 LED values, returns true if any changed
+VISIBLE_IF_KUNIT bool maschine_jam_render_smartstrip_leds(struct maschine_jam_smartstrip_display_state* smartstrip_display_states, uint8_t *smartstrip_leds){
 	uint8_t i;
 	uint8_t smartstrip_number;
 	uint8_t smartstrip_led_index;
+	uint8_t led_state;
+	bool changed = false;
 	struct maschine_jam_smartstrip_display_state* smartstrip_display_state;
 	
 	for (i=0; i<MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS; i++){
 		smartstrip_number = i / MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP;
 		smartstrip_led_index = i % MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP;
-		smartstrip_display_state = &driver_data->hid_report_led_smartstrips_display_states[smartstrip_number];
-		driver_data->hid_report_led_smartstrips[i] = maschine_jam_get_smartstrip_led_state(smartstrip_display_state, smartstrip_led_index);
-		//printk(KERN_ALERT "maschine_jam_refresh_hid_report_led_smartstrips: number: %d, index: %d, value: %d\n", smartstrip_number, smartstrip_led_index, driver_data->hid_report_led_smartstrips[i]);
+		smartstrip_display_state = &smartstrip_display_states[smartstrip_number];
+		led_state = maschine_jam_get_smartstrip_led_state(smartstrip_display_state, smartstrip_led_index);
+		if (smartstrip_leds[i] != led_state){
+			smartstrip_leds[i] = led_state;
+			changed = true;
+		}
+		//printk(KERN_ALERT "maschine_jam_render_smartstrip_leds: number: %d, index: %d, value: %d\n", smartstrip_number, smartstrip_led_index, smartstrip_leds[i]);
 	}
+	return changed;
+}
+EXPORT_SYMBOL_IF_KUNIT(maschine_jam_render_smartstrip_leds);
+// returns true if any smartstrip led changed
+static inline bool maschine_jam_refresh_hid_report_led_smartstrips(struct maschine_jam_driver_data *driver_data){
+	return maschine_jam_render_smartstrip_leds(driver_data->hid_report_led_smartstrips_display_states, driver_data->hid_report_led_smartstrips);
 }
 
-// get virtual midi data and transmit to physical maschine jam, cannot block
-static void maschine_jam_midi_out_trigger(struct snd_rawmidi_substream *substream, int up){
-	//static int num;
-	int sequencer_status;
+// returns true if the LED's report just became dirty and a frame needs to be requested
+static inline bool maschine_jam_set_led(struct maschine_jam_driver_data *driver_data, uint8_t report, uint8_t index, uint8_t value){
 	unsigned long flags;
-	uint8_t data;
-	struct maschine_jam_driver_data *driver_data = substream->rmidi->private_data;
-	struct maschine_jam_output_node* sentinal_node;
-	struct maschine_jam_output_node* output_node;
-	uint8_t write_value;
-	struct snd_seq_event midi_event;
-	unsigned int sysex_len;
-	uint8_t* sysex_ptr;
+	bool became_dirty = false;
+
+	switch (report){
+		case MJ_OUTPUT_BUTTON_LED_NODE:
+			spin_lock_irqsave(&driver_data->hid_report_led_buttons_lock, flags);
+			became_dirty = maschine_jam_hid_output_report_set_led(&driver_data->hid_report_led_buttons_output, &driver_data->hid_report_led_buttons[index], value);
+			spin_unlock_irqrestore(&driver_data->hid_report_led_buttons_lock, flags);
+			break;
+		case MJ_OUTPUT_PAD_LED_NODE:
+			spin_lock_irqsave(&driver_data->hid_report_led_pads_lock, flags);
+			became_dirty = maschine_jam_hid_output_report_set_led(&driver_data->hid_report_led_pads_output, &driver_data->hid_report_led_pads[index], value);
+			spin_unlock_irqrestore(&driver_data->hid_report_led_pads_lock, flags);
+			break;
+		case MJ_OUTPUT_SMARTSTRIP_LED_NODE:
+			spin_lock_irqsave(&driver_data->hid_report_led_smartstrips_lock, flags);
+			became_dirty = maschine_jam_hid_output_report_set_led(&driver_data->hid_report_led_smartstrips_output, &driver_data->hid_report_led_smartstrips[index], value);
+			spin_unlock_irqrestore(&driver_data->hid_report_led_smartstrips_lock, flags);
+			break;
+		default:
+			printk(KERN_NOTICE "maschine_jam_set_led: invalid report found\n");
+			break;
+	}
+	return became_dirty;
+}
+
+static void maschine_jam_midi_out_route(struct maschine_jam_driver_data *driver_data, enum maschine_jam_midi_out_routing_type routing_type, uint8_t channel, uint8_t key, uint8_t value){
+	unsigned int routing_slot = maschine_jam_midi_out_routing_slot(routing_type, channel, key);
+	struct maschine_jam_midi_out_routing_table* routing_table;
+	struct maschine_jam_midi_out_target* target;
+	struct maschine_jam_midi_out_target* target_end;
+
+	rcu_read_lock();
+	routing_table = rcu_dereference(driver_data->midi_out_routing_table);
+	target = &routing_table->targets[routing_table->offsets[routing_slot]];
+	target_end = &routing_table->targets[routing_table->offsets[routing_slot + 1]];
+	if (target == target_end){
+		this_cpu_inc(driver_data->stats->midi_out_unmapped);
+	}
+	for (; target < target_end; target++){
+		if (maschine_jam_set_led(driver_data, target->report, target->index, value)){
+			maschine_jam_led_frame_request(driver_data);
+		}
+	}
+	rcu_read_unlock();
+}
+static void maschine_jam_midi_out_sysex(struct maschine_jam_driver_data *driver_data, uint8_t *sysex, unsigned int sysex_length){
+	unsigned long flags;
+	uint8_t *sysex_ptr = &sysex[11];
+	bool schedule;
 	uint8_t i;
 
-	if (up != 0) {
-		while (snd_rawmidi_transmit(substream, &data, 1) == 1) {
-			//printk(KERN_NOTICE "%d - out_trigger data - %d", num++, data);
-			spin_lock_irqsave(&driver_data->midi_out_encoder_lock, flags);
-			sequencer_status = snd_midi_event_encode_byte(driver_data->midi_out_encoder, data, &midi_event);
-			spin_unlock_irqrestore(&driver_data->midi_out_encoder_lock, flags);
-			//printk(KERN_NOTICE "snd_midi_event_encode: sequencer status: %d", sequencer_status);
-			if (sequencer_status == 0) {
-				continue;
-			} else if (sequencer_status == 1) {
-				if (snd_seq_ev_is_channel_type(&midi_event)){
-					if (snd_seq_ev_is_note_type(&midi_event)){
-						sentinal_node = &driver_data->midi_out_note_mapping[midi_event.data.note.channel][midi_event.data.note.note];
-						write_value = midi_event.data.note.velocity;
-					} else if (snd_seq_ev_is_control_type(&midi_event)){
-						sentinal_node = &driver_data->midi_out_control_change_mapping[midi_event.data.control.channel][midi_event.data.control.param];
-						write_value = midi_event.data.control.value;
-					} else {
-						printk(KERN_ALERT "sequencer event type is not note or control but still channel...\n");
-						return;
-					}
-					spin_lock_irqsave(&driver_data->midi_out_mapping_lock, flags);
-					output_node = sentinal_node->node_list_head;
-					if (output_node == NULL){
-						if (snd_seq_ev_is_note_type(&midi_event)){
-							printk(KERN_NOTICE "unmapped note_event: channel:%d, note:%d, velocity:%d\n", \
-								midi_event.data.note.channel,
-								midi_event.data.note.note,
-								midi_event.data.note.velocity
-							);
-						} else if (snd_seq_ev_is_control_type(&midi_event)){
-							printk(KERN_NOTICE "unmapped control_event: channel:%d, param:%d, value:%d\n", \
-								midi_event.data.control.channel,
-								midi_event.data.control.param,
-								midi_event.data.control.value
-							);
-						}
-					} else {
-						while(output_node != NULL){
-							if (output_node->type == MJ_OUTPUT_BUTTON_LED_NODE){
-								spin_lock(&driver_data->hid_report_led_buttons_lock);
-								driver_data->hid_report_led_buttons[output_node->index] = write_value;
-								spin_unlock(&driver_data->hid_report_led_buttons_lock);
-								schedule_work(&driver_data->hid_report_led_buttons_work);
-							}else if(output_node->type == MJ_OUTPUT_PAD_LED_NODE){
-								spin_lock(&driver_data->hid_report_led_pads_lock);
-								driver_data->hid_report_led_pads[output_node->index] = write_value;
-								spin_unlock(&driver_data->hid_report_led_pads_lock);
-								schedule_work(&driver_data->hid_report_led_pads_work);
-							}else if(output_node->type == MJ_OUTPUT_SMARTSTRIP_LED_NODE){
-								spin_lock(&driver_data->hid_report_led_smartstrips_lock);
-								driver_data->hid_report_led_smartstrips[output_node->index] = write_value;
-								spin_unlock(&driver_data->hid_report_led_smartstrips_lock);
-								schedule_work(&driver_data->hid_report_led_smartstrips_work);
-							}else{
-								printk(KERN_NOTICE "snd_midi_event_encode: invalid node type found\n");
-							}
-							output_node = output_node->next;
-						}
-					}
-					spin_unlock_irqrestore(&driver_data->midi_out_mapping_lock, flags);
-				} else if (snd_seq_ev_is_variable_type(&midi_event)){
-					sysex_len = midi_event.data.ext.len;
-					sysex_ptr = &((uint8_t*)midi_event.data.ext.ptr)[11];
-					printk(KERN_NOTICE "snd_midi_event_encode: variable event_type, length=%d\n", sysex_len);
-					if (sysex_len == 20){
-						printk(KERN_ALERT "maschine_jam_midi_out_trigger: data.ext.ptr[11]=%02X\n", sysex_ptr[0]);
-						spin_lock(&driver_data->hid_report_led_smartstrips_lock);
-						for (i=0; i<MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
-							driver_data->hid_report_led_smartstrips_display_states[i].value = sysex_ptr[i];
-						}
-						maschine_jam_refresh_hid_report_led_smartstrips(driver_data);
-						spin_unlock(&driver_data->hid_report_led_smartstrips_lock);
-						schedule_work(&driver_data->hid_report_led_smartstrips_work);
-					} else if (sysex_len == 28){
-						printk(KERN_ALERT "maschine_jam_midi_out_trigger: data.ext.ptr[11-12]=%02X%02X\n", sysex_ptr[0], sysex_ptr[1]);
-						spin_lock(&driver_data->hid_report_led_smartstrips_lock);
-						for (i=0; i<MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
-							driver_data->hid_report_led_smartstrips_display_states[i].mode = sysex_ptr[2 * i];
-							driver_data->hid_report_led_smartstrips_display_states[i].color = sysex_ptr[(2*i)+1];
-						}
-						maschine_jam_refresh_hid_report_led_smartstrips(driver_data);
-						spin_unlock(&driver_data->hid_report_led_smartstrips_lock);
-						schedule_work(&driver_data->hid_report_led_smartstrips_work);
-					} else {
-						printk(KERN_ALERT "snd_midi_event_encode: unknwon variable event_type length:%d\n", sysex_len);
+	if (sysex_length == 20){
+		//printk(KERN_NOTICE "maschine_jam_midi_out_sysex: sysex[11]=%02X\n", sysex_ptr[0]);
+		spin_lock_irqsave(&driver_data->hid_report_led_smartstrips_lock, flags);
+		for (i=0; i<MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
+			driver_data->hid_report_led_smartstrips_display_states[i].value = sysex_ptr[i];
+		}
+		schedule = maschine_jam_refresh_hid_report_led_smartstrips(driver_data) && maschine_jam_hid_output_report_mark_dirty(&driver_data->hid_report_led_smartstrips_output);
+		spin_unlock_irqrestore(&driver_data->hid_report_led_smartstrips_lock, flags);
+		if (schedule){
+			maschine_jam_led_frame_request(driver_data);
+		}
+	} else if (sysex_length == 28){
+		//printk(KERN_NOTICE "maschine_jam_midi_out_sysex: sysex[11-12]=%02X%02X\n", sysex_ptr[0], sysex_ptr[1]);
+		spin_lock_irqsave(&driver_data->hid_report_led_smartstrips_lock, flags);
+		for (i=0; i<MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
+			driver_data->hid_report_led_smartstrips_display_states[i].mode = sysex_ptr[2 * i];
+			driver_data->hid_report_led_smartstrips_display_states[i].color = sysex_ptr[(2*i)+1];
+		}
+		schedule = maschine_jam_refresh_hid_report_led_smartstrips(driver_data) && maschine_jam_hid_output_report_mark_dirty(&driver_data->hid_report_led_smartstrips_output);
+		spin_unlock_irqrestore(&driver_data->hid_report_led_smartstrips_lock, flags);
+		if (schedule){
+			maschine_jam_led_frame_request(driver_data);
+		}
+	} else {
+		printk(KERN_ALERT "maschine_jam_midi_out_sysex: unknown sysex length:%d\n", sysex_length);
+	}
+}
+static inline uint8_t maschine_jam_midi_out_data_bytes(uint8_t status){
+	switch (status & 0xF0){
+		case 0xC0: // program change
+		case 0xD0: // channel pressure
+			return 1;
+		default:
+			return 2;
+	}
+}
+// Feed a block of MIDI bytes through the parser, must be called with midi_out_parser_lock held.
+// Note on, note off and key pressure are routed as notes, control change as control change;
+// other channel messages are consumed and dropped.
+static void maschine_jam_midi_out_parse(struct maschine_jam_driver_data *driver_data, const uint8_t *bytes, unsigned int length){
+	struct maschine_jam_midi_out_parser *parser = &driver_data->midi_out_parser;
+	unsigned int i;
+	uint8_t byte;
+
+	for (i = 0; i < length; i++){
+		byte = bytes[i];
+		if (byte >= 0xF8){
+			// real time messages may appear anywhere and leave running status alone
+			continue;
+		}
+		if (byte & 0x80){
+			if (parser->in_sysex){
+				parser->in_sysex = false;
+				if (byte == 0xF7){
+					if (parser->sysex_length < MASCHINE_JAM_SYSEX_MAX_LENGTH){
+						parser->sysex[parser->sysex_length] = byte;
 					}
-				} else {
-					printk(KERN_ALERT "snd_midi_event_encode: unknwon event_type:%d\n", midi_event.type);
+					parser->sysex_length++;
+					maschine_jam_midi_out_sysex(driver_data, parser->sysex, parser->sysex_length);
+					continue;
 				}
-			} else if (sequencer_status < 0){
-				printk(KERN_ALERT "snd_midi_event_encode: sequencer status: %d\n", sequencer_status);
 			}
+			parser->data_length = 0;
+			if (byte == 0xF0){
+				parser->in_sysex = true;
+				parser->sysex[0] = byte;
+				parser->sysex_length = 1;
+				parser->running_status = 0;
+			} else if (byte >= 0xF0){
+				// system common, its data bytes are dropped below
+				parser->running_status = 0;
+			} else {
+				parser->running_status = byte;
+			}
+			continue;
+		}
+		if (parser->in_sysex){
+			if (parser->sysex_length < MASCHINE_JAM_SYSEX_MAX_LENGTH){
+				parser->sysex[parser->sysex_length] = byte;
+			}
+			parser->sysex_length++;
+			continue;
+		}
+		if (parser->running_status == 0){
+			continue;
+		}
+		parser->data[parser->data_length++] = byte;
+		if (parser->data_length < maschine_jam_midi_out_data_bytes(parser->running_status)){
+			continue;
+		}
+		parser->data_length = 0;
+		switch (parser->running_status & 0xF0){
+			case 0x80: // note off
+			case 0x90: // note on
+			case 0xA0: // key pressure
+				maschine_jam_midi_out_route(driver_data, MJ_MIDI_OUT_ROUTING_NOTE, parser->running_status & 0x0F, parser->data[0], parser->data[1]);
+				break;
+			case 0xB0:
+				maschine_jam_midi_out_route(driver_data, MJ_MIDI_OUT_ROUTING_CONTROL_CHANGE, parser->running_status & 0x0F, parser->data[0], parser->data[1]);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+// get virtual midi data and transmit to physical maschine jam, cannot block
+// Bytes are peeked a block at a time, parsed, then acknowledged together.
+static void maschine_jam_midi_out_trigger(struct snd_rawmidi_substream *substream, int up){
+	unsigned long flags;
+	int count;
+	struct maschine_jam_driver_data *driver_data = substream->rmidi->private_data;
+
+	if (up != 0) {
+		spin_lock_irqsave(&driver_data->midi_out_parser_lock, flags);
+		while ((count = snd_rawmidi_transmit_peek(substream, driver_data->midi_out_chunk, MASCHINE_JAM_MIDI_OUT_CHUNK_BYTES)) > 0) {
+			this_cpu_add(driver_data->stats->midi_bytes_out, count);
+			maschine_jam_midi_out_parse(driver_data, driver_data->midi_out_chunk, count);
+			snd_rawmidi_transmit_ack(substream, count);
 		}
+		spin_unlock_irqrestore(&driver_data->midi_out_parser_lock, flags);
 	}else{
 		printk(KERN_ALERT "midi_out_trigger: up = 0\n");
 	}
@@ -2482,9 +2793,168 @@ static int maschine_jam_delete_sound_card(struct maschine_jam_driver_data *drive
 	return error_code;
 }
 
+static inline struct maschine_jam_driver_data* maschine_jam_io_dir_get_driver_data(struct kobject *kobj){
+	struct kobject *maschine_jam_kobj = kobj->parent;
+	struct device *dev = container_of(maschine_jam_kobj, struct device, kobj);
+	struct hid_device *hdev = container_of(dev, struct hid_device, dev);
+
+	return hid_get_drvdata(hdev);
+}
+static ssize_t maschine_jam_inputs_ring_depth_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", kfifo_size(&driver_data->input_ring));
+}
+static ssize_t maschine_jam_inputs_ring_overruns_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+	unsigned int cpu;
+	u64 input_ring_overruns = 0;
+
+	for_each_possible_cpu(cpu){
+		input_ring_overruns += per_cpu_ptr(driver_data->stats, cpu)->input_ring_overruns;
+	}
+	return scnprintf(buf, PAGE_SIZE, "%llu\n", input_ring_overruns);
+}
+// One consistent copy of all three report caches:
+//   buttons <15 bytes in hex, bit n of the bitmap is button n>
+//   knobs <position 0-15 of each knob>
+//   smartstrips <touch value 0-1023 of finger A and finger B of each smartstrip>
+// The driver notifies the attribute whenever a report changes the state, so a client can poll()
+// it for POLLPRI and read it again from offset 0.
+static ssize_t maschine_jam_inputs_state_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+	uint8_t knobs[MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES];
+	uint8_t buttons[MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES];
+	uint8_t smartstrips[MASCHINE_JAM_HID_REPORT_02_BYTES];
+	struct maschine_jam_smartstrip smartstrip;
+	unsigned int sequence, i;
+	ssize_t length;
+
+	do {
+		sequence = read_seqbegin(&driver_data->input_state_lock);
+		memcpy(knobs, driver_data->inputs.hid_report01_data_knobs, sizeof(knobs));
+		memcpy(buttons, driver_data->inputs.hid_report01_data_buttons, sizeof(buttons));
+		memcpy(smartstrips, driver_data->inputs.hid_report02_data_smartstrips, sizeof(smartstrips));
+	} while (read_seqretry(&driver_data->input_state_lock, sequence));
+
+	length = scnprintf(buf, PAGE_SIZE, "buttons %*phN\nknobs", (int)sizeof(buttons), buttons);
+	for (i = 0; i < MASCHINE_JAM_NUMBER_KNOBS; i++){
+		length += scnprintf(&buf[length], PAGE_SIZE - length, " %u", maschine_jam_get_knob_nibble(knobs, i));
+	}
+	length += scnprintf(&buf[length], PAGE_SIZE - length, "\nsmartstrips");
+	for (i = 0; i < MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
+		smartstrip = maschine_jam_get_smartstrip(smartstrips, i);
+		length += scnprintf(&buf[length], PAGE_SIZE - length, " %u %u", smartstrip.touch_value[0], smartstrip.touch_value[1]);
+	}
+	length += scnprintf(&buf[length], PAGE_SIZE - length, "\n");
+	return length;
+}
+static struct kobj_attribute maschine_jam_inputs_state_attribute = {
+	.attr = {.name = "state", .mode = MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS},
+	.show = maschine_jam_inputs_state_show,
+};
+static struct kobj_attribute maschine_jam_inputs_ring_depth_attribute = {
+	.attr = {.name = "ring_depth", .mode = MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS},
+	.show = maschine_jam_inputs_ring_depth_show,
+};
+static struct kobj_attribute maschine_jam_inputs_ring_overruns_attribute = {
+	.attr = {.name = "ring_overruns", .mode = MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS},
+	.show = maschine_jam_inputs_ring_overruns_show,
+};
+static struct attribute *maschine_jam_inputs_attributes[] = {
+	&maschine_jam_inputs_state_attribute.attr,
+	&maschine_jam_inputs_ring_depth_attribute.attr,
+	&maschine_jam_inputs_ring_overruns_attribute.attr,
+	NULL
+};
+static const struct attribute_group maschine_jam_inputs_group = {
+	.attrs = maschine_jam_inputs_attributes,
+};
+static ssize_t maschine_jam_outputs_led_refresh_rate_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(driver_data->led_refresh_rate));
+}
+static ssize_t maschine_jam_outputs_led_refresh_rate_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+	unsigned int led_refresh_rate;
+
+	if (kstrtouint(buf, 10, &led_refresh_rate) != 0 || led_refresh_rate < MASCHINE_JAM_LED_REFRESH_RATE_MIN || led_refresh_rate > MASCHINE_JAM_LED_REFRESH_RATE_MAX){
+		printk(KERN_ALERT "maschine_jam_outputs_led_refresh_rate_store: rate must be %d-%d Hz\n", MASCHINE_JAM_LED_REFRESH_RATE_MIN, MASCHINE_JAM_LED_REFRESH_RATE_MAX);
+		return -EINVAL;
+	}
+	WRITE_ONCE(driver_data->led_refresh_rate, led_refresh_rate);
+	return count;
+}
+static ssize_t maschine_jam_outputs_led_frames_sent_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%lu\n", READ_ONCE(driver_data->led_frames_sent));
+}
+static ssize_t maschine_jam_outputs_led_updates_coalesced_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%lu\n",
+		READ_ONCE(driver_data->hid_report_led_buttons_output.updates_coalesced) +
+		READ_ONCE(driver_data->hid_report_led_pads_output.updates_coalesced) +
+		READ_ONCE(driver_data->hid_report_led_smartstrips_output.updates_coalesced)
+	);
+}
+static ssize_t maschine_jam_outputs_led_workqueue_cpu_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", READ_ONCE(driver_data->led_workqueue_cpu));
+}
+static ssize_t maschine_jam_outputs_led_workqueue_cpu_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_io_dir_get_driver_data(kobj);
+	int cpu;
+
+	if (kstrtoint(buf, 10, &cpu) != 0){
+		printk(KERN_ALERT "maschine_jam_outputs_led_workqueue_cpu_store: invalid cpu\n");
+		return -EINVAL;
+	}
+	if (cpu != MASCHINE_JAM_LED_WORKQUEUE_CPU_UNPINNED && (cpu < 0 || cpu >= nr_cpu_ids || !cpu_online(cpu))){
+		printk(KERN_ALERT "maschine_jam_outputs_led_workqueue_cpu_store: cpu %d is not online\n", cpu);
+		return -EINVAL;
+	}
+	WRITE_ONCE(driver_data->led_workqueue_cpu, cpu);
+	// let a frame already queued on the previous cpu finish before returning
+	flush_workqueue(driver_data->led_workqueue);
+	return count;
+}
+static struct kobj_attribute maschine_jam_outputs_led_refresh_rate_attribute = {
+	.attr = {.name = "led_refresh_rate", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+	.show = maschine_jam_outputs_led_refresh_rate_show,
+	.store = maschine_jam_outputs_led_refresh_rate_store,
+};
+static struct kobj_attribute maschine_jam_outputs_led_frames_sent_attribute = {
+	.attr = {.name = "led_frames_sent", .mode = MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS},
+	.show = maschine_jam_outputs_led_frames_sent_show,
+};
+static struct kobj_attribute maschine_jam_outputs_led_updates_coalesced_attribute = {
+	.attr = {.name = "led_updates_coalesced", .mode = MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS},
+	.show = maschine_jam_outputs_led_updates_coalesced_show,
+};
+static struct kobj_attribute maschine_jam_outputs_led_workqueue_cpu_attribute = {
+	.attr = {.name = "led_workqueue_cpu", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+	.show = maschine_jam_outputs_led_workqueue_cpu_show,
+	.store = maschine_jam_outputs_led_workqueue_cpu_store,
+};
+static struct attribute *maschine_jam_outputs_attributes[] = {
+	&maschine_jam_outputs_led_refresh_rate_attribute.attr,
+	&maschine_jam_outputs_led_workqueue_cpu_attribute.attr,
+	&maschine_jam_outputs_led_frames_sent_attribute.attr,
+	&maschine_jam_outputs_led_updates_coalesced_attribute.attr,
+	NULL
+};
+static const struct attribute_group maschine_jam_outputs_group = {
+	.attrs = maschine_jam_outputs_attributes,
+};
+
 static int maschine_jam_create_sysfs_inputs_interface(struct maschine_jam_driver_data *driver_data){
 	int error_code = 0;
 	struct kobject* directory_inputs = NULL;
+	struct kernfs_node *inputs_state_dirent = NULL;
 	struct kobject* directory_inputs_knobs = NULL;
 	struct kobject* directory_inputs_buttons = NULL;
 	struct kobject* directory_inputs_smartstrips = NULL;
@@ -2496,15 +2966,27 @@ static int maschine_jam_create_sysfs_inputs_interface(struct maschine_jam_driver
 		error_code = -1;
 		goto return_error_code;
 	}
+	error_code = sysfs_create_group(directory_inputs, &maschine_jam_inputs_group);
+	if (error_code < 0) {
+		printk(KERN_ALERT "sysfs_create_group inputs failed!\n");
+		goto failure_delete_kobject_inputs;
+	}
+	// looked up once, every input report that changes the state notifies it
+	inputs_state_dirent = sysfs_get_dirent(directory_inputs->sd, "state");
+	if (inputs_state_dirent == NULL) {
+		printk(KERN_ALERT "sysfs_get_dirent state failed!\n");
+		error_code = -ENOENT;
+		goto failure_remove_inputs_group;
+	}
 	directory_inputs_knobs = kobject_create_and_add("knobs", directory_inputs);
 	if (directory_inputs_knobs == NULL) {
 		printk(KERN_ALERT "kobject_create_and_add knobs failed!\n");
 		error_code = -1;
-		goto failure_delete_kobject_inputs;
+		goto failure_put_inputs_state_dirent;
 	}
-	error_code = sysfs_create_groups(directory_inputs_knobs, maschine_jam_inputs_knobs_groups);
+	error_code = maschine_jam_create_sysfs_control_groups(driver_data, directory_inputs_knobs, IO_ATTRIBUTE_INPUT_KNOB);
 	if (error_code < 0) {
-		printk(KERN_ALERT "sysfs_create_groups knobs failed!\n");
+		printk(KERN_ALERT "maschine_jam_create_sysfs_control_groups knobs failed!\n");
 		goto failure_delete_kobject_inputs_knobs;
 	}
 	directory_inputs_buttons = kobject_create_and_add("buttons", directory_inputs);
@@ -2513,9 +2995,9 @@ static int maschine_jam_create_sysfs_inputs_interface(struct maschine_jam_driver
 		error_code = -1;
 		goto failure_remove_inputs_knobs_groups;
 	}
-	error_code = sysfs_create_groups(directory_inputs_buttons, maschine_jam_inputs_buttons_groups);
+	error_code = maschine_jam_create_sysfs_control_groups(driver_data, directory_inputs_buttons, IO_ATTRIBUTE_INPUT_BUTTON);
 	if (error_code < 0) {
-		printk(KERN_ALERT "sysfs_create_groups buttons failed!\n");
+		printk(KERN_ALERT "maschine_jam_create_sysfs_control_groups buttons failed!\n");
 		goto failure_delete_kobject_inputs_buttons;
 	}
 	directory_inputs_smartstrips = kobject_create_and_add("smartstrips", directory_inputs);
@@ -2524,12 +3006,13 @@ static int maschine_jam_create_sysfs_inputs_interface(struct maschine_jam_driver
 		error_code = -1;
 		goto failure_remove_inputs_buttons_groups;
 	}
-	error_code = sysfs_create_groups(directory_inputs_smartstrips, maschine_jam_inputs_smartstrips_groups);
+	error_code = maschine_jam_create_sysfs_control_groups(driver_data, directory_inputs_smartstrips, IO_ATTRIBUTE_INPUT_SMARTSTRIP);
 	if (error_code < 0) {
-		printk(KERN_ALERT "sysfs_create_groups failed!\n");
+		printk(KERN_ALERT "maschine_jam_create_sysfs_control_groups failed!\n");
 		goto failure_delete_kobject_inputs_smartstrips;
 	}
 	driver_data->directory_inputs = directory_inputs;
+	driver_data->inputs_state_dirent = inputs_state_dirent;
 	driver_data->directory_inputs_knobs = directory_inputs_knobs;
 	driver_data->directory_inputs_buttons = directory_inputs_buttons;
 	driver_data->directory_inputs_smartstrips = directory_inputs_smartstrips;
@@ -2538,13 +3021,17 @@ static int maschine_jam_create_sysfs_inputs_interface(struct maschine_jam_driver
 failure_delete_kobject_inputs_smartstrips:
 	kobject_del(directory_inputs_smartstrips);
 failure_remove_inputs_buttons_groups:
-	sysfs_remove_groups(directory_inputs_buttons, maschine_jam_inputs_buttons_groups);
+	maschine_jam_delete_sysfs_control_groups(driver_data, directory_inputs_buttons, IO_ATTRIBUTE_INPUT_BUTTON);
 failure_delete_kobject_inputs_buttons:
 	kobject_del(directory_inputs_buttons);
 failure_remove_inputs_knobs_groups:
-	sysfs_remove_groups(directory_inputs_knobs, maschine_jam_inputs_knobs_groups);
+	maschine_jam_delete_sysfs_control_groups(driver_data, directory_inputs_knobs, IO_ATTRIBUTE_INPUT_KNOB);
 failure_delete_kobject_inputs_knobs:
 	kobject_del(directory_inputs_knobs);
+failure_put_inputs_state_dirent:
+	sysfs_put(inputs_state_dirent);
+failure_remove_inputs_group:
+	sysfs_remove_group(directory_inputs, &maschine_jam_inputs_group);
 failure_delete_kobject_inputs:
 	kobject_del(directory_inputs);
 return_error_code:
@@ -2552,18 +3039,23 @@ return_error_code:
 }
 static void maschine_jam_delete_sysfs_inputs_interface(struct maschine_jam_driver_data *driver_data){
 	if (driver_data->directory_inputs_smartstrips != NULL){
-		sysfs_remove_groups(driver_data->directory_inputs_smartstrips, maschine_jam_inputs_smartstrips_groups);
+		maschine_jam_delete_sysfs_control_groups(driver_data, driver_data->directory_inputs_smartstrips, IO_ATTRIBUTE_INPUT_SMARTSTRIP);
 		kobject_del(driver_data->directory_inputs_smartstrips);
 	}
 	if (driver_data->directory_inputs_buttons != NULL){
-		sysfs_remove_groups(driver_data->directory_inputs_buttons, maschine_jam_inputs_buttons_groups);
+		maschine_jam_delete_sysfs_control_groups(driver_data, driver_data->directory_inputs_buttons, IO_ATTRIBUTE_INPUT_BUTTON);
 		kobject_del(driver_data->directory_inputs_buttons);
 	}
 	if (driver_data->directory_inputs_knobs != NULL){
-		sysfs_remove_groups(driver_data->directory_inputs_knobs, maschine_jam_inputs_knobs_groups);
+		maschine_jam_delete_sysfs_control_groups(driver_data, driver_data->directory_inputs_knobs, IO_ATTRIBUTE_INPUT_KNOB);
 		kobject_del(driver_data->directory_inputs_knobs);
 	}
+	if (driver_data->inputs_state_dirent != NULL){
+		sysfs_put(driver_data->inputs_state_dirent);
+		driver_data->inputs_state_dirent = NULL;
+	}
 	if (driver_data->directory_inputs != NULL){
+		sysfs_remove_group(driver_data->directory_inputs, &maschine_jam_inputs_group);
 		kobject_del(driver_data->directory_inputs);
 	}
 }
@@ -2581,15 +3073,20 @@ static int maschine_jam_create_sysfs_outputs_interface(struct maschine_jam_drive
 		error_code = -1;
 		goto return_error_code;
 	}
+	error_code = sysfs_create_group(directory_outputs, &maschine_jam_outputs_group);
+	if (error_code < 0) {
+		printk(KERN_ALERT "sysfs_create_group outputs failed!\n");
+		goto failure_delete_kobject_outputs;
+	}
 	directory_outputs_button_leds = kobject_create_and_add("button_leds", directory_outputs);
 	if (directory_outputs_button_leds == NULL) {
 		printk(KERN_ALERT "kobject_create_and_add buttons failed!\n");
 		error_code = -1;
-		goto failure_delete_kobject_outputs;
+		goto failure_remove_outputs_group;
 	}
-	error_code = sysfs_create_groups(directory_outputs_button_leds, maschine_jam_outputs_button_led_groups);
+	error_code = maschine_jam_create_sysfs_control_groups(driver_data, directory_outputs_button_leds, IO_ATTRIBUTE_OUTPUT_BUTTON_LED);
 	if (error_code < 0) {
-		printk(KERN_ALERT "sysfs_create_groups buttons failed!\n");
+		printk(KERN_ALERT "maschine_jam_create_sysfs_control_groups buttons failed!\n");
 		goto failure_delete_kobject_outputs_button_leds;
 	}
 	directory_outputs_pad_leds = kobject_create_and_add("pad_leds", directory_outputs);
@@ -2598,9 +3095,9 @@ static int maschine_jam_create_sysfs_outputs_interface(struct maschine_jam_drive
 		error_code = -1;
 		goto failure_remove_outputs_button_leds_groups;
 	}
-	error_code = sysfs_create_groups(directory_outputs_pad_leds, maschine_jam_outputs_pad_led_groups);
+	error_code = maschine_jam_create_sysfs_control_groups(driver_data, directory_outputs_pad_leds, IO_ATTRIBUTE_OUTPUT_PAD_LED);
 	if (error_code < 0) {
-		printk(KERN_ALERT "sysfs_create_groups pads failed!\n");
+		printk(KERN_ALERT "maschine_jam_create_sysfs_control_groups pads failed!\n");
 		goto failure_delete_kobject_outputs_pad_leds;
 	}
 	directory_outputs_smartstrip_leds = kobject_create_and_add("smartstrip_leds", directory_outputs);
@@ -2609,9 +3106,9 @@ static int maschine_jam_create_sysfs_outputs_interface(struct maschine_jam_drive
 		error_code = -1;
 		goto failure_remove_outputs_pad_leds_groups;
 	}
-	error_code = sysfs_create_groups(directory_outputs_smartstrip_leds, maschine_jam_outputs_smartstrip_led_groups);
+	error_code = maschine_jam_create_sysfs_control_groups(driver_data, directory_outputs_smartstrip_leds, IO_ATTRIBUTE_OUTPUT_SMARTSTRIP_LED);
 	if (error_code < 0) {
-		printk(KERN_ALERT "sysfs_create_groups smartstrips failed!\n");
+		printk(KERN_ALERT "maschine_jam_create_sysfs_control_groups smartstrips failed!\n");
 		goto failure_delete_kobject_outputs_smartstrip_leds;
 	}
 	driver_data->directory_outputs = directory_outputs;
@@ -2623,13 +3120,15 @@ static int maschine_jam_create_sysfs_outputs_interface(struct maschine_jam_drive
 failure_delete_kobject_outputs_smartstrip_leds:
 	kobject_del(directory_outputs_smartstrip_leds);
 failure_remove_outputs_pad_leds_groups:
-	sysfs_remove_groups(directory_outputs_pad_leds, maschine_jam_outputs_pad_led_groups);
+	maschine_jam_delete_sysfs_control_groups(driver_data, directory_outputs_pad_leds, IO_ATTRIBUTE_OUTPUT_PAD_LED);
 failure_delete_kobject_outputs_pad_leds:
 	kobject_del(directory_outputs_pad_leds);
 failure_remove_outputs_button_leds_groups:
-	sysfs_remove_groups(directory_outputs_button_leds, maschine_jam_outputs_button_led_groups);
+	maschine_jam_delete_sysfs_control_groups(driver_data, directory_outputs_button_leds, IO_ATTRIBUTE_OUTPUT_BUTTON_LED);
 failure_delete_kobject_outputs_button_leds:
 	kobject_del(directory_outputs_button_leds);
+failure_remove_outputs_group:
+	sysfs_remove_group(directory_outputs, &maschine_jam_outputs_group);
 failure_delete_kobject_outputs:
 	kobject_del(directory_outputs);
 return_error_code:
@@ -2637,31 +3136,1026 @@ return_error_code:
 }
 static void maschine_jam_delete_sysfs_outputs_interface(struct maschine_jam_driver_data *driver_data){
 	if (driver_data->directory_outputs_smartstrip_leds != NULL){
+		maschine_jam_delete_sysfs_control_groups(driver_data, driver_data->directory_outputs_smartstrip_leds, IO_ATTRIBUTE_OUTPUT_SMARTSTRIP_LED);
 		kobject_del(driver_data->directory_outputs_smartstrip_leds);
 	}
 	if (driver_data->directory_outputs_pad_leds != NULL){
+		maschine_jam_delete_sysfs_control_groups(driver_data, driver_data->directory_outputs_pad_leds, IO_ATTRIBUTE_OUTPUT_PAD_LED);
 		kobject_del(driver_data->directory_outputs_pad_leds);
 	}
 	if (driver_data->directory_outputs_button_leds != NULL){
+		maschine_jam_delete_sysfs_control_groups(driver_data, driver_data->directory_outputs_button_leds, IO_ATTRIBUTE_OUTPUT_BUTTON_LED);
 		kobject_del(driver_data->directory_outputs_button_leds);
 	}
 	if (driver_data->directory_outputs != NULL){
+		sysfs_remove_group(driver_data->directory_outputs, &maschine_jam_outputs_group);
 		kobject_del(driver_data->directory_outputs);
 	}
 }
 
+// The profile attribute reads and writes the whole mapping as text, one control per line with the
+// sysfs path of the control, then channel, type and key as the per control attributes take them:
+//   maschine_jam_profile 1
+//   inputs/buttons/song 0 control_change 30
+//   outputs/pad_leds/matrix_1x1 0 note 22
+//   end
+// Blank lines and lines starting with # are skipped. A profile is applied when its end line is
+// written, writes in between are collected in profile_staging.
+static const char *maschine_jam_profile_midi_type_names[] = {
+	[MJ_MIDI_TYPE_NOTE] = "note",
+	[MJ_MIDI_TYPE_AFTERTOUCH] = "aftertouch",
+	[MJ_MIDI_TYPE_CONTROL_CHANGE] = "control_change",
+};
+static struct maschine_jam_midi_config* maschine_jam_profile_get_midi_config(struct maschine_jam_profile *profile, struct maschine_jam_io_attribute *io_attribute){
+	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_KNOB){
+		return &profile->midi_in_knob_configs[io_attribute->io_index];
+	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_BUTTON){
+		return &profile->midi_in_button_configs[io_attribute->io_index];
+	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_INPUT_SMARTSTRIP){
+		return &profile->midi_in_smartstrip_configs[io_attribute->io_index][io_attribute->smartstrip_finger][io_attribute->smartstrip_finger_mode];
+	}
+	return NULL;
+}
+static struct maschine_jam_output_node* maschine_jam_profile_get_output_node(struct maschine_jam_profile *profile, struct maschine_jam_io_attribute *io_attribute){
+	if (io_attribute->io_attribute_type == IO_ATTRIBUTE_OUTPUT_BUTTON_LED){
+		return &profile->midi_out_button_led_nodes[io_attribute->io_index];
+	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_OUTPUT_PAD_LED){
+		return &profile->midi_out_pad_led_nodes[io_attribute->io_index];
+	} else if (io_attribute->io_attribute_type == IO_ATTRIBUTE_OUTPUT_SMARTSTRIP_LED){
+		return &profile->midi_out_smartstrip_led_nodes[io_attribute->io_index];
+	}
+	return NULL;
+}
+// must hold midi_out_mapping_mutex
+static void maschine_jam_profile_snapshot(struct maschine_jam_driver_data *driver_data, struct maschine_jam_profile *profile){
+	memcpy(profile->midi_in_knob_configs, driver_data->inputs.midi_in_knob_configs, sizeof(profile->midi_in_knob_configs));
+	memcpy(profile->midi_in_button_configs, driver_data->inputs.midi_in_button_configs, sizeof(profile->midi_in_button_configs));
+	memcpy(profile->midi_in_smartstrip_configs, driver_data->inputs.midi_in_smartstrip_configs, sizeof(profile->midi_in_smartstrip_configs));
+	memcpy(profile->midi_out_button_led_nodes, driver_data->midi_out_button_led_nodes, sizeof(profile->midi_out_button_led_nodes));
+	memcpy(profile->midi_out_pad_led_nodes, driver_data->midi_out_pad_led_nodes, sizeof(profile->midi_out_pad_led_nodes));
+	memcpy(profile->midi_out_smartstrip_led_nodes, driver_data->midi_out_smartstrip_led_nodes, sizeof(profile->midi_out_smartstrip_led_nodes));
+}
+static size_t maschine_jam_profile_print(struct maschine_jam_profile *profile, char *text, size_t size){
+	unsigned int i, j;
+	size_t length;
+	struct maschine_jam_io_attribute io_attribute;
+	struct maschine_jam_midi_config *midi_config;
+	struct maschine_jam_output_node *output_node;
+
+	length = scnprintf(text, size, "maschine_jam_profile %d\n", MASCHINE_JAM_PROFILE_VERSION);
+	for (i = 0; i < MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES; i++){
+		for (j = 0; j < MJ_NUMBER_CONTROLS; j++){
+			if (!maschine_jam_control_get_io_attribute(&maschine_jam_controls[j], i, &io_attribute)){
+				continue;
+			}
+			midi_config = maschine_jam_profile_get_midi_config(profile, &io_attribute);
+			output_node = maschine_jam_profile_get_output_node(profile, &io_attribute);
+			if (midi_config != NULL){
+				length += scnprintf(&text[length], size - length, "%s/%s %u %s %u\n", maschine_jam_control_directory_paths[i], maschine_jam_controls[j].name,
+					midi_config->channel, midi_config->type <= MJ_MIDI_TYPE_CONTROL_CHANGE ? maschine_jam_profile_midi_type_names[midi_config->type] : "unknown", midi_config->key);
+			} else if (output_node != NULL){
+				length += scnprintf(&text[length], size - length, "%s/%s %u %s %u\n", maschine_jam_control_directory_paths[i], maschine_jam_controls[j].name,
+					output_node->channel, output_node->midi_type == SNDRV_SEQ_EVENT_CONTROLLER ? "control_change" : "note", output_node->key);
+			}
+		}
+	}
+	length += scnprintf(&text[length], size - length, "end\n");
+	return length;
+}
+static int maschine_jam_profile_parse_line(struct maschine_jam_profile *profile, char *line){
+	unsigned int i, channel, key;
+	char path[48], type[16];
+	char *name;
+	const struct maschine_jam_control *control;
+	struct maschine_jam_io_attribute io_attribute;
+	struct maschine_jam_midi_config *midi_config;
+	struct maschine_jam_output_node *output_node;
+	enum maschine_jam_midi_type midi_type;
+
+	if (sscanf(line, "%47s %u %15s %u", path, &channel, type, &key) != 4 || channel >= MASCHINE_JAM_MIDI_CHANNELS_MAX || key >= MASCHINE_JAM_MIDI_NOTES_MAX){
+		return -EINVAL;
+	}
+	name = strrchr(path, '/');
+	if (name == NULL){
+		return -EINVAL;
+	}
+	*name++ = '\0';
+	for (i = 0; i < MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES; i++){
+		if (strcmp(maschine_jam_control_directory_paths[i], path) == 0){
+			break;
+		}
+	}
+	control = maschine_jam_control_find(name);
+	if (i == MASCHINE_JAM_NUMBER_CONTROL_DIRECTORIES || control == NULL || !maschine_jam_control_get_io_attribute(control, i, &io_attribute)){
+		return -ENOENT;
+	}
+	midi_config = maschine_jam_profile_get_midi_config(profile, &io_attribute);
+	output_node = maschine_jam_profile_get_output_node(profile, &io_attribute);
+	if (midi_config != NULL){
+		for (midi_type = MJ_MIDI_TYPE_NOTE; midi_type <= MJ_MIDI_TYPE_CONTROL_CHANGE; midi_type++){
+			if (strcmp(type, maschine_jam_profile_midi_type_names[midi_type]) == 0){
+				break;
+			}
+		}
+		if (midi_type > MJ_MIDI_TYPE_CONTROL_CHANGE){
+			return -EINVAL;
+		}
+		midi_config->type = midi_type;
+		midi_config->channel = channel;
+		midi_config->key = key;
+		maschine_jam_midi_config_compile(midi_config);
+	} else if (output_node != NULL){
+		if (strcmp(type, "note") == 0){
+			output_node->midi_type = SNDRV_SEQ_EVENT_NOTE;
+		} else if (strcmp(type, "control_change") == 0){
+			output_node->midi_type = SNDRV_SEQ_EVENT_CONTROLLER;
+		} else {
+			return -EINVAL;
+		}
+		output_node->channel = channel;
+		output_node->key = key;
+	}
+	return 0;
+}
+static int maschine_jam_profile_parse(struct maschine_jam_profile *profile, char *text){
+	char *line;
+	unsigned int line_number = 0;
+	unsigned int version;
+	bool has_header = false;
+
+	while ((line = strsep(&text, "\n")) != NULL){
+		line_number++;
+		line = strim(line);
+		if (line[0] == '\0' || line[0] == '#'){
+			continue;
+		}
+		if (!has_header){
+			if (sscanf(line, "maschine_jam_profile %u", &version) != 1 || version != MASCHINE_JAM_PROFILE_VERSION){
+				printk(KERN_ALERT "maschine_jam_profile_parse - line %u: expected maschine_jam_profile %d\n", line_number, MASCHINE_JAM_PROFILE_VERSION);
+				return -EINVAL;
+			}
+			has_header = true;
+		} else if (strcmp(line, "end") == 0){
+			return 0;
+		} else if (maschine_jam_profile_parse_line(profile, line) != 0){
+			printk(KERN_ALERT "maschine_jam_profile_parse - line %u: invalid control, channel, type or key\n", line_number);
+			return -EINVAL;
+		}
+	}
+	return -EINVAL;
+}
+static int maschine_jam_profile_apply(struct maschine_jam_driver_data *driver_data, char *text){
+	int error_code;
+	struct maschine_jam_profile *profile;
+	struct maschine_jam_midi_out_routing_table *routing_table;
+
+	profile = kmalloc(sizeof(struct maschine_jam_profile), GFP_KERNEL);
+	if (profile == NULL){
+		return -ENOMEM;
+	}
+	mutex_lock(&driver_data->midi_out_mapping_mutex);
+	maschine_jam_profile_snapshot(driver_data, profile);
+	error_code = maschine_jam_profile_parse(profile, text);
+	if (error_code == 0){
+		// built before anything is changed, a failed allocation leaves the old mapping in place
+		routing_table = maschine_jam_midi_out_routing_table_build(profile->midi_out_button_led_nodes, profile->midi_out_pad_led_nodes, profile->midi_out_smartstrip_led_nodes);
+		if (routing_table == NULL){
+			error_code = -ENOMEM;
+		} else {
+			memcpy(driver_data->midi_out_button_led_nodes, profile->midi_out_button_led_nodes, sizeof(driver_data->midi_out_button_led_nodes));
+			memcpy(driver_data->midi_out_pad_led_nodes, profile->midi_out_pad_led_nodes, sizeof(driver_data->midi_out_pad_led_nodes));
+			memcpy(driver_data->midi_out_smartstrip_led_nodes, profile->midi_out_smartstrip_led_nodes, sizeof(driver_data->midi_out_smartstrip_led_nodes));
+			maschine_jam_midi_out_routing_table_publish(driver_data, routing_table);
+		}
+	}
+	mutex_unlock(&driver_data->midi_out_mapping_mutex);
+	if (error_code == 0){
+		// the profile and the pointer to it are visible before the worker can see the bit
+		WRITE_ONCE(driver_data->midi_in_pending_profile, profile);
+		smp_mb__before_atomic();
+		set_bit(MJ_MIDI_IN_APPLY_PROFILE, &driver_data->midi_in_flags);
+		queue_work(driver_data->input_workqueue, &driver_data->input_work);
+		flush_work(&driver_data->input_work);
+		WRITE_ONCE(driver_data->midi_in_pending_profile, NULL);
+	}
+	kfree(profile);
+	return error_code;
+}
+static inline struct maschine_jam_driver_data* maschine_jam_profile_get_driver_data(struct kobject *kobj){
+	struct device *dev = container_of(kobj, struct device, kobj);
+	struct hid_device *hdev = container_of(dev, struct hid_device, dev);
+
+	return hid_get_drvdata(hdev);
+}
+static ssize_t maschine_jam_profile_read(struct file *filp, struct kobject *kobj, struct bin_attribute *attr, char *buf, loff_t off, size_t count){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_profile_get_driver_data(kobj);
+	struct maschine_jam_profile *profile;
+	char *text;
+	size_t length;
+	ssize_t return_value;
+
+	profile = kmalloc(sizeof(struct maschine_jam_profile), GFP_KERNEL);
+	text = kvmalloc(MASCHINE_JAM_PROFILE_MAX_BYTES, GFP_KERNEL);
+	if (profile == NULL || text == NULL){
+		return_value = -ENOMEM;
+	} else {
+		mutex_lock(&driver_data->midi_out_mapping_mutex);
+		maschine_jam_profile_snapshot(driver_data, profile);
+		mutex_unlock(&driver_data->midi_out_mapping_mutex);
+		length = maschine_jam_profile_print(profile, text, MASCHINE_JAM_PROFILE_MAX_BYTES);
+		return_value = memory_read_from_buffer(buf, count, &off, text, length);
+	}
+	kvfree(text);
+	kfree(profile);
+	return return_value;
+}
+// true once the last non-blank line is end
+static bool maschine_jam_profile_is_complete(const char *text, size_t length){
+	while (length > 0 && isspace(text[length - 1])){
+		length--;
+	}
+	return length >= 3 && strncmp(&text[length - 3], "end", 3) == 0 && (length == 3 || text[length - 4] == '\n');
+}
+static ssize_t maschine_jam_profile_write(struct file *filp, struct kobject *kobj, struct bin_attribute *attr, char *buf, loff_t off, size_t count){
+	struct maschine_jam_driver_data *driver_data = maschine_jam_profile_get_driver_data(kobj);
+	ssize_t return_value = count;
+	int error_code;
+
+	mutex_lock(&driver_data->profile_mutex);
+	if (driver_data->profile_staging == NULL){
+		driver_data->profile_staging = kvmalloc(MASCHINE_JAM_PROFILE_MAX_BYTES + 1, GFP_KERNEL);
+		if (driver_data->profile_staging == NULL){
+			return_value = -ENOMEM;
+			goto unlock_profile_mutex;
+		}
+	}
+	// a write at offset 0 starts a new profile, later writes have to continue it
+	if (off == 0){
+		driver_data->profile_staging_length = 0;
+	}
+	if (off != driver_data->profile_staging_length || off + count > MASCHINE_JAM_PROFILE_MAX_BYTES){
+		printk(KERN_ALERT "maschine_jam_profile_write - write at %lld does not continue the profile\n", off);
+		driver_data->profile_staging_length = 0;
+		return_value = -EINVAL;
+		goto unlock_profile_mutex;
+	}
+	memcpy(&driver_data->profile_staging[off], buf, count);
+	driver_data->profile_staging_length += count;
+	if (maschine_jam_profile_is_complete(driver_data->profile_staging, driver_data->profile_staging_length)){
+		driver_data->profile_staging[driver_data->profile_staging_length] = '\0';
+		driver_data->profile_staging_length = 0;
+		error_code = maschine_jam_profile_apply(driver_data, driver_data->profile_staging);
+		if (error_code != 0){
+			return_value = error_code;
+		}
+	}
+unlock_profile_mutex:
+	mutex_unlock(&driver_data->profile_mutex);
+	return return_value;
+}
+static struct bin_attribute maschine_jam_profile_attribute = {
+	.attr = {.name = "profile", .mode = MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS},
+	.size = MASCHINE_JAM_PROFILE_MAX_BYTES,
+	.read = maschine_jam_profile_read,
+	.write = maschine_jam_profile_write,
+};
+static int maschine_jam_create_sysfs_profile_interface(struct maschine_jam_driver_data *driver_data){
+	return sysfs_create_bin_file(&driver_data->mj_hid_device->dev.kobj, &maschine_jam_profile_attribute);
+}
+// a profile write queues the input work, remove the file before the work is cancelled
+static void maschine_jam_delete_sysfs_profile_interface(struct maschine_jam_driver_data *driver_data){
+	sysfs_remove_bin_file(&driver_data->mj_hid_device->dev.kobj, &maschine_jam_profile_attribute);
+	kvfree(driver_data->profile_staging);
+	driver_data->profile_staging = NULL;
+}
+
+// Built-in mappings, applied in probe over the sequential default layout before any report is
+// delivered, so a unit is usable without a userspace step. The profile module parameter picks one
+// by name, default keeps the sequential layout. Controls a table does not list keep their default.
+struct maschine_jam_builtin_mapping {
+	uint16_t control; // enum maschine_jam_control_id
+	uint8_t io_attribute_type;
+	uint8_t type;
+	uint8_t channel;
+	uint8_t key;
+};
+#define MJ_BUILTIN_INPUT(_kind, _name, _type, _channel, _key) \
+	{ .control = MJ_CONTROL_ ## _name, .io_attribute_type = IO_ATTRIBUTE_INPUT_ ## _kind, .type = MJ_MIDI_TYPE_ ## _type, .channel = _channel, .key = _key }
+#define MJ_BUILTIN_OUTPUT_TYPE_NOTE SNDRV_SEQ_EVENT_NOTE
+#define MJ_BUILTIN_OUTPUT_TYPE_CONTROL_CHANGE SNDRV_SEQ_EVENT_CONTROLLER
+#define MJ_BUILTIN_OUTPUT(_kind, _name, _type, _channel, _key) \
+	{ .control = MJ_CONTROL_ ## _name, .io_attribute_type = IO_ATTRIBUTE_OUTPUT_ ## _kind, .type = MJ_BUILTIN_OUTPUT_TYPE_ ## _type, .channel = _channel, .key = _key }
+
+// scripts/controller_mapping_bitwig.sh
+static const struct maschine_jam_builtin_mapping maschine_jam_builtin_mapping_bitwig[] = {
+	MJ_BUILTIN_INPUT(BUTTON, song, CONTROL_CHANGE, 0, 30),
+	MJ_BUILTIN_INPUT(BUTTON, step, CONTROL_CHANGE, 0, 31),
+	MJ_BUILTIN_INPUT(BUTTON, pad_mode, CONTROL_CHANGE, 0, 32),
+	MJ_BUILTIN_INPUT(BUTTON, clear, CONTROL_CHANGE, 0, 95),
+	MJ_BUILTIN_INPUT(BUTTON, duplicate, CONTROL_CHANGE, 0, 96),
+	MJ_BUILTIN_INPUT(BUTTON, navigate_up, CONTROL_CHANGE, 0, 40),
+	MJ_BUILTIN_INPUT(BUTTON, navigate_down, CONTROL_CHANGE, 0, 41),
+	MJ_BUILTIN_INPUT(BUTTON, navigate_left, CONTROL_CHANGE, 0, 42),
+	MJ_BUILTIN_INPUT(BUTTON, navigate_right, CONTROL_CHANGE, 0, 43),
+	MJ_BUILTIN_INPUT(BUTTON, scene_1, NOTE, 1, 0),
+	MJ_BUILTIN_INPUT(BUTTON, scene_2, NOTE, 1, 1),
+	MJ_BUILTIN_INPUT(BUTTON, scene_3, NOTE, 1, 2),
+	MJ_BUILTIN_INPUT(BUTTON, scene_4, NOTE, 1, 3),
+	MJ_BUILTIN_INPUT(BUTTON, scene_5, NOTE, 1, 4),
+	MJ_BUILTIN_INPUT(BUTTON, scene_6, NOTE, 1, 5),
+	MJ_BUILTIN_INPUT(BUTTON, scene_7, NOTE, 1, 6),
+	MJ_BUILTIN_INPUT(BUTTON, scene_8, NOTE, 1, 7),
+	MJ_BUILTIN_INPUT(BUTTON, group_a, NOTE, 1, 8),
+	MJ_BUILTIN_INPUT(BUTTON, group_b, NOTE, 1, 9),
+	MJ_BUILTIN_INPUT(BUTTON, group_c, NOTE, 1, 10),
+	MJ_BUILTIN_INPUT(BUTTON, group_d, NOTE, 1, 11),
+	MJ_BUILTIN_INPUT(BUTTON, group_e, NOTE, 1, 12),
+	MJ_BUILTIN_INPUT(BUTTON, group_f, NOTE, 1, 13),
+	MJ_BUILTIN_INPUT(BUTTON, group_g, NOTE, 1, 14),
+	MJ_BUILTIN_INPUT(BUTTON, group_h, NOTE, 1, 15),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_1x1, NOTE, 0, 22),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_1x2, NOTE, 0, 23),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_1x3, NOTE, 0, 24),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_1x4, NOTE, 0, 25),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_1x5, NOTE, 0, 26),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_1x6, NOTE, 0, 27),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_1x7, NOTE, 0, 28),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_1x8, NOTE, 0, 29),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_2x1, NOTE, 0, 30),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_2x2, NOTE, 0, 31),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_2x3, NOTE, 0, 32),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_2x4, NOTE, 0, 33),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_2x5, NOTE, 0, 34),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_2x6, NOTE, 0, 35),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_2x7, NOTE, 0, 36),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_2x8, NOTE, 0, 37),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_3x1, NOTE, 0, 38),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_3x2, NOTE, 0, 39),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_3x3, NOTE, 0, 40),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_3x4, NOTE, 0, 41),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_3x5, NOTE, 0, 42),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_3x6, NOTE, 0, 43),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_3x7, NOTE, 0, 44),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_3x8, NOTE, 0, 45),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_4x1, NOTE, 0, 46),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_4x2, NOTE, 0, 47),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_4x3, NOTE, 0, 48),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_4x4, NOTE, 0, 49),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_4x5, NOTE, 0, 50),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_4x6, NOTE, 0, 51),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_4x7, NOTE, 0, 52),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_4x8, NOTE, 0, 53),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_5x1, NOTE, 0, 54),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_5x2, NOTE, 0, 55),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_5x3, NOTE, 0, 56),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_5x4, NOTE, 0, 57),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_5x5, NOTE, 0, 58),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_5x6, NOTE, 0, 59),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_5x7, NOTE, 0, 60),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_5x8, NOTE, 0, 61),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_6x1, NOTE, 0, 62),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_6x2, NOTE, 0, 63),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_6x3, NOTE, 0, 64),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_6x4, NOTE, 0, 65),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_6x5, NOTE, 0, 66),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_6x6, NOTE, 0, 67),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_6x7, NOTE, 0, 68),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_6x8, NOTE, 0, 69),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_7x1, NOTE, 0, 70),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_7x2, NOTE, 0, 71),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_7x3, NOTE, 0, 72),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_7x4, NOTE, 0, 73),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_7x5, NOTE, 0, 74),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_7x6, NOTE, 0, 75),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_7x7, NOTE, 0, 76),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_7x8, NOTE, 0, 77),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_8x1, NOTE, 0, 78),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_8x2, NOTE, 0, 79),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_8x3, NOTE, 0, 80),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_8x4, NOTE, 0, 81),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_8x5, NOTE, 0, 82),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_8x6, NOTE, 0, 83),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_8x7, NOTE, 0, 84),
+	MJ_BUILTIN_INPUT(BUTTON, matrix_8x8, NOTE, 0, 85),
+	MJ_BUILTIN_INPUT(BUTTON, mst, CONTROL_CHANGE, 0, 60),
+	MJ_BUILTIN_INPUT(BUTTON, grp, CONTROL_CHANGE, 0, 61),
+	MJ_BUILTIN_INPUT(BUTTON, in_1, CONTROL_CHANGE, 0, 62),
+	MJ_BUILTIN_INPUT(BUTTON, cue, CONTROL_CHANGE, 0, 63),
+	MJ_BUILTIN_INPUT(BUTTON, encoder_push, CONTROL_CHANGE, 0, 87),
+	MJ_BUILTIN_INPUT(BUTTON, encoder_touch, CONTROL_CHANGE, 0, 88),
+	MJ_BUILTIN_INPUT(BUTTON, browse, CONTROL_CHANGE, 0, 44),
+	MJ_BUILTIN_INPUT(BUTTON, macro, CONTROL_CHANGE, 0, 90),
+	MJ_BUILTIN_INPUT(BUTTON, level, CONTROL_CHANGE, 0, 91),
+	MJ_BUILTIN_INPUT(BUTTON, aux, CONTROL_CHANGE, 0, 92),
+	MJ_BUILTIN_INPUT(BUTTON, control, CONTROL_CHANGE, 0, 97),
+	MJ_BUILTIN_INPUT(BUTTON, auto, CONTROL_CHANGE, 0, 98),
+	MJ_BUILTIN_INPUT(BUTTON, perform, CONTROL_CHANGE, 0, 45),
+	MJ_BUILTIN_INPUT(BUTTON, notes, CONTROL_CHANGE, 0, 46),
+	MJ_BUILTIN_INPUT(BUTTON, lock, CONTROL_CHANGE, 0, 47),
+	MJ_BUILTIN_INPUT(BUTTON, tune, CONTROL_CHANGE, 0, 48),
+	MJ_BUILTIN_INPUT(BUTTON, swing, CONTROL_CHANGE, 0, 49),
+	MJ_BUILTIN_INPUT(BUTTON, select, CONTROL_CHANGE, 0, 80),
+	MJ_BUILTIN_INPUT(BUTTON, play, CONTROL_CHANGE, 0, 108),
+	MJ_BUILTIN_INPUT(BUTTON, rec, CONTROL_CHANGE, 0, 109),
+	MJ_BUILTIN_INPUT(BUTTON, page_left, CONTROL_CHANGE, 0, 107),
+	MJ_BUILTIN_INPUT(BUTTON, page_right, CONTROL_CHANGE, 0, 104),
+	MJ_BUILTIN_INPUT(BUTTON, tempo, CONTROL_CHANGE, 0, 110),
+	MJ_BUILTIN_INPUT(BUTTON, grid, CONTROL_CHANGE, 0, 113),
+	MJ_BUILTIN_INPUT(BUTTON, solo, CONTROL_CHANGE, 0, 111),
+	MJ_BUILTIN_INPUT(BUTTON, mute, CONTROL_CHANGE, 0, 112),
+
+	MJ_BUILTIN_INPUT(KNOB, encoder, CONTROL_CHANGE, 0, 86),
+
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 1AS, CONTROL_CHANGE, 0, 8),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 2AS, CONTROL_CHANGE, 0, 9),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 3AS, CONTROL_CHANGE, 0, 10),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 4AS, CONTROL_CHANGE, 0, 11),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 5AS, CONTROL_CHANGE, 0, 12),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 6AS, CONTROL_CHANGE, 0, 13),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 7AS, CONTROL_CHANGE, 0, 14),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 8AS, CONTROL_CHANGE, 0, 15),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 1BS, CONTROL_CHANGE, 0, 16),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 2BS, CONTROL_CHANGE, 0, 17),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 3BS, CONTROL_CHANGE, 0, 18),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 4BS, CONTROL_CHANGE, 0, 19),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 5BS, CONTROL_CHANGE, 0, 20),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 6BS, CONTROL_CHANGE, 0, 21),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 7BS, CONTROL_CHANGE, 0, 22),
+	MJ_BUILTIN_INPUT(SMARTSTRIP, 8BS, CONTROL_CHANGE, 0, 23),
+
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, song, CONTROL_CHANGE, 0, 30),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, step, CONTROL_CHANGE, 0, 31),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, pad_mode, CONTROL_CHANGE, 0, 32),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, clear, CONTROL_CHANGE, 0, 95),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, duplicate, CONTROL_CHANGE, 0, 96),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, navigate_up, CONTROL_CHANGE, 0, 40),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, navigate_down, CONTROL_CHANGE, 0, 41),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, navigate_left, CONTROL_CHANGE, 0, 42),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, navigate_right, CONTROL_CHANGE, 0, 43),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, mst, CONTROL_CHANGE, 0, 60),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, grp, CONTROL_CHANGE, 0, 61),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, in_1, CONTROL_CHANGE, 0, 62),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, cue, CONTROL_CHANGE, 0, 63),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, browse, CONTROL_CHANGE, 0, 44),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, macro, CONTROL_CHANGE, 0, 90),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level, CONTROL_CHANGE, 0, 91),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, aux, CONTROL_CHANGE, 0, 92),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, control, CONTROL_CHANGE, 0, 97),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, auto, CONTROL_CHANGE, 0, 98),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, perform, CONTROL_CHANGE, 0, 45),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, notes, CONTROL_CHANGE, 0, 46),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, lock, CONTROL_CHANGE, 0, 47),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, tune, CONTROL_CHANGE, 0, 48),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, swing, CONTROL_CHANGE, 0, 49),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, select, CONTROL_CHANGE, 0, 80),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, play, CONTROL_CHANGE, 0, 108),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, rec, CONTROL_CHANGE, 0, 109),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, page_left, CONTROL_CHANGE, 0, 107),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, page_right, CONTROL_CHANGE, 0, 104),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, tempo, CONTROL_CHANGE, 0, 110),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, grid, CONTROL_CHANGE, 0, 113),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, solo, CONTROL_CHANGE, 0, 111),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, mute, CONTROL_CHANGE, 0, 112),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_left_1, CONTROL_CHANGE, 0, 8),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_left_2, CONTROL_CHANGE, 0, 9),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_left_3, CONTROL_CHANGE, 0, 10),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_left_4, CONTROL_CHANGE, 0, 11),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_left_5, CONTROL_CHANGE, 0, 12),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_left_6, CONTROL_CHANGE, 0, 13),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_left_7, CONTROL_CHANGE, 0, 14),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_left_8, CONTROL_CHANGE, 0, 15),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_right_1, CONTROL_CHANGE, 0, 20),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_right_2, CONTROL_CHANGE, 0, 21),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_right_3, CONTROL_CHANGE, 0, 22),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_right_4, CONTROL_CHANGE, 0, 23),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_right_5, CONTROL_CHANGE, 0, 24),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_right_6, CONTROL_CHANGE, 0, 25),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_right_7, CONTROL_CHANGE, 0, 26),
+	MJ_BUILTIN_OUTPUT(BUTTON_LED, level_right_8, CONTROL_CHANGE, 0, 27),
+
+	MJ_BUILTIN_OUTPUT(PAD_LED, scene_1, NOTE, 1, 0),
+	MJ_BUILTIN_OUTPUT(PAD_LED, scene_2, NOTE, 1, 1),
+	MJ_BUILTIN_OUTPUT(PAD_LED, scene_3, NOTE, 1, 2),
+	MJ_BUILTIN_OUTPUT(PAD_LED, scene_4, NOTE, 1, 3),
+	MJ_BUILTIN_OUTPUT(PAD_LED, scene_5, NOTE, 1, 4),
+	MJ_BUILTIN_OUTPUT(PAD_LED, scene_6, NOTE, 1, 5),
+	MJ_BUILTIN_OUTPUT(PAD_LED, scene_7, NOTE, 1, 6),
+	MJ_BUILTIN_OUTPUT(PAD_LED, scene_8, NOTE, 1, 7),
+	MJ_BUILTIN_OUTPUT(PAD_LED, group_a, NOTE, 1, 8),
+	MJ_BUILTIN_OUTPUT(PAD_LED, group_b, NOTE, 1, 9),
+	MJ_BUILTIN_OUTPUT(PAD_LED, group_c, NOTE, 1, 10),
+	MJ_BUILTIN_OUTPUT(PAD_LED, group_d, NOTE, 1, 11),
+	MJ_BUILTIN_OUTPUT(PAD_LED, group_e, NOTE, 1, 12),
+	MJ_BUILTIN_OUTPUT(PAD_LED, group_f, NOTE, 1, 13),
+	MJ_BUILTIN_OUTPUT(PAD_LED, group_g, NOTE, 1, 14),
+	MJ_BUILTIN_OUTPUT(PAD_LED, group_h, NOTE, 1, 15),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_1x1, NOTE, 0, 22),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_1x2, NOTE, 0, 23),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_1x3, NOTE, 0, 24),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_1x4, NOTE, 0, 25),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_1x5, NOTE, 0, 26),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_1x6, NOTE, 0, 27),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_1x7, NOTE, 0, 28),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_1x8, NOTE, 0, 29),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_2x1, NOTE, 0, 30),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_2x2, NOTE, 0, 31),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_2x3, NOTE, 0, 32),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_2x4, NOTE, 0, 33),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_2x5, NOTE, 0, 34),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_2x6, NOTE, 0, 35),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_2x7, NOTE, 0, 36),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_2x8, NOTE, 0, 37),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_3x1, NOTE, 0, 38),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_3x2, NOTE, 0, 39),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_3x3, NOTE, 0, 40),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_3x4, NOTE, 0, 41),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_3x5, NOTE, 0, 42),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_3x6, NOTE, 0, 43),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_3x7, NOTE, 0, 44),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_3x8, NOTE, 0, 45),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_4x1, NOTE, 0, 46),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_4x2, NOTE, 0, 47),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_4x3, NOTE, 0, 48),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_4x4, NOTE, 0, 49),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_4x5, NOTE, 0, 50),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_4x6, NOTE, 0, 51),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_4x7, NOTE, 0, 52),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_4x8, NOTE, 0, 53),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_5x1, NOTE, 0, 54),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_5x2, NOTE, 0, 55),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_5x3, NOTE, 0, 56),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_5x4, NOTE, 0, 57),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_5x5, NOTE, 0, 58),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_5x6, NOTE, 0, 59),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_5x7, NOTE, 0, 60),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_5x8, NOTE, 0, 61),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_6x1, NOTE, 0, 62),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_6x2, NOTE, 0, 63),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_6x3, NOTE, 0, 64),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_6x4, NOTE, 0, 65),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_6x5, NOTE, 0, 66),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_6x6, NOTE, 0, 67),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_6x7, NOTE, 0, 68),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_6x8, NOTE, 0, 69),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_7x1, NOTE, 0, 70),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_7x2, NOTE, 0, 71),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_7x3, NOTE, 0, 72),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_7x4, NOTE, 0, 73),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_7x5, NOTE, 0, 74),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_7x6, NOTE, 0, 75),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_7x7, NOTE, 0, 76),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_7x8, NOTE, 0, 77),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_8x1, NOTE, 0, 78),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_8x2, NOTE, 0, 79),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_8x3, NOTE, 0, 80),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_8x4, NOTE, 0, 81),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_8x5, NOTE, 0, 82),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_8x6, NOTE, 0, 83),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_8x7, NOTE, 0, 84),
+	MJ_BUILTIN_OUTPUT(PAD_LED, matrix_8x8, NOTE, 0, 85),
+};
+
+struct maschine_jam_builtin_profile {
+	const char *name;
+	const struct maschine_jam_builtin_mapping *mappings;
+	unsigned int number_mappings;
+};
+static const struct maschine_jam_builtin_profile maschine_jam_builtin_profiles[] = {
+	{ "bitwig", maschine_jam_builtin_mapping_bitwig, ARRAY_SIZE(maschine_jam_builtin_mapping_bitwig) },
+};
+static const struct maschine_jam_builtin_profile* maschine_jam_builtin_profile_find(const char *name){
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(maschine_jam_builtin_profiles); i++){
+		if (strcmp(maschine_jam_builtin_profiles[i].name, name) == 0){
+			return &maschine_jam_builtin_profiles[i];
+		}
+	}
+	return NULL;
+}
+// called from probe before the routing table is built
+static void maschine_jam_builtin_profile_apply(struct maschine_jam_driver_data *driver_data, const char *name){
+	const struct maschine_jam_builtin_profile *builtin_profile;
+	const struct maschine_jam_builtin_mapping *mapping;
+	struct maschine_jam_io_attribute io_attribute;
+	struct maschine_jam_midi_config *midi_config;
+	struct maschine_jam_output_node *output_node;
+	unsigned int i;
+
+	if (name == NULL || name[0] == '\0' || strcmp(name, "default") == 0){
+		return;
+	}
+	builtin_profile = maschine_jam_builtin_profile_find(name);
+	if (builtin_profile == NULL){
+		printk(KERN_ALERT "Unknown built-in profile %s, keeping the default mapping.\n", name);
+		return;
+	}
+	for (i = 0; i < builtin_profile->number_mappings; i++){
+		mapping = &builtin_profile->mappings[i];
+		if (!maschine_jam_control_get_io_attribute(&maschine_jam_controls[mapping->control], mapping->io_attribute_type, &io_attribute)){
+			continue;
+		}
+		midi_config = maschine_jam_inputs_get_midi_config(driver_data, &io_attribute);
+		if (midi_config != NULL){
+			midi_config->type = mapping->type;
+			midi_config->channel = mapping->channel;
+			midi_config->key = mapping->key;
+			maschine_jam_midi_config_compile(midi_config);
+			continue;
+		}
+		if (io_attribute.io_attribute_type == IO_ATTRIBUTE_OUTPUT_BUTTON_LED){
+			output_node = &driver_data->midi_out_button_led_nodes[io_attribute.io_index];
+		} else if (io_attribute.io_attribute_type == IO_ATTRIBUTE_OUTPUT_PAD_LED){
+			output_node = &driver_data->midi_out_pad_led_nodes[io_attribute.io_index];
+		} else if (io_attribute.io_attribute_type == IO_ATTRIBUTE_OUTPUT_SMARTSTRIP_LED){
+			output_node = &driver_data->midi_out_smartstrip_led_nodes[io_attribute.io_index];
+		} else {
+			continue;
+		}
+		output_node->midi_type = mapping->type;
+		output_node->channel = mapping->channel;
+		output_node->key = mapping->key;
+	}
+	printk(KERN_NOTICE "Applied built-in profile %s.\n", builtin_profile->name);
+}
+
+static void maschine_jam_stats_sum(struct maschine_jam_driver_data *driver_data, struct maschine_jam_stats *sum){
+	unsigned int cpu, i;
+	const u64 *cpu_counters;
+	u64 *sum_counters = (u64 *)sum;
+
+	BUILD_BUG_ON(sizeof(struct maschine_jam_stats) % sizeof(u64) != 0);
+	memset(sum, 0, sizeof(*sum));
+	for_each_possible_cpu(cpu){
+		cpu_counters = (const u64 *)per_cpu_ptr(driver_data->stats, cpu);
+		for (i = 0; i < sizeof(struct maschine_jam_stats) / sizeof(u64); i++){
+			sum_counters[i] += cpu_counters[i];
+		}
+	}
+}
+static int maschine_jam_debugfs_stats_show(struct seq_file *s, void *unused){
+	struct maschine_jam_driver_data *driver_data = s->private;
+	struct maschine_jam_stats sum;
+
+	maschine_jam_stats_sum(driver_data, &sum);
+	seq_printf(s, "reports_received_01: %llu\n", sum.reports_received[MJ_STATS_REPORT_01]);
+	seq_printf(s, "reports_received_02: %llu\n", sum.reports_received[MJ_STATS_REPORT_02]);
+	seq_printf(s, "reports_received_unknown: %llu\n", sum.reports_received[MJ_STATS_REPORT_UNKNOWN]);
+	seq_printf(s, "reports_bad_size: %llu\n", sum.reports_bad_size);
+	seq_printf(s, "input_ring_overruns: %llu\n", sum.input_ring_overruns);
+	seq_printf(s, "capture_dropped: %llu\n", sum.capture_dropped);
+	seq_printf(s, "replay_reports: %llu\n", sum.replay_reports);
+	seq_printf(s, "replay_live_reports_dropped: %llu\n", sum.replay_live_reports_dropped);
+	seq_printf(s, "midi_bytes_in: %llu\n", sum.midi_bytes_in);
+	seq_printf(s, "midi_bytes_out: %llu\n", sum.midi_bytes_out);
+	seq_printf(s, "midi_out_unmapped: %llu\n", sum.midi_out_unmapped);
+	seq_printf(s, "rawmidi_short_writes: %llu\n", sum.rawmidi_short_writes);
+	seq_printf(s, "led_frames_sent: %lu\n", driver_data->led_frames_sent);
+	seq_printf(s, "led_reports_sent: %llu\n", sum.led_reports_sent);
+	seq_printf(s, "led_reports_failed: %llu\n", sum.led_reports_failed);
+	seq_printf(s, "led_updates_coalesced: %lu\n",
+		driver_data->hid_report_led_buttons_output.updates_coalesced +
+		driver_data->hid_report_led_pads_output.updates_coalesced +
+		driver_data->hid_report_led_smartstrips_output.updates_coalesced
+	);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(maschine_jam_debugfs_stats);
+static void maschine_jam_debugfs_show_histogram(struct seq_file *s, const u64 *histogram){
+	unsigned int i;
+
+	seq_printf(s, "%-14s %s\n", "ns_min", "count");
+	for (i = 0; i < MASCHINE_JAM_LATENCY_HISTOGRAM_BUCKETS; i++){
+		if (histogram[i] != 0){
+			seq_printf(s, "%-14llu %llu\n", i == 0 ? 0ULL : 1ULL << (i - 1), histogram[i]);
+		}
+	}
+}
+static int maschine_jam_debugfs_input_latency_show(struct seq_file *s, void *unused){
+	struct maschine_jam_driver_data *driver_data = s->private;
+	struct maschine_jam_stats sum;
+
+	maschine_jam_stats_sum(driver_data, &sum);
+	maschine_jam_debugfs_show_histogram(s, sum.input_latency);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(maschine_jam_debugfs_input_latency);
+static int maschine_jam_debugfs_output_latency_show(struct seq_file *s, void *unused){
+	struct maschine_jam_driver_data *driver_data = s->private;
+	struct maschine_jam_stats sum;
+
+	maschine_jam_stats_sum(driver_data, &sum);
+	maschine_jam_debugfs_show_histogram(s, sum.output_latency);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(maschine_jam_debugfs_output_latency);
+// Reading capture streams the recorded reports: it blocks while a capture runs and the ring is
+// empty, and ends once the capture is stopped and drained. Writing 1 starts a capture, which
+// discards anything left from the previous one, writing 0 stops it.
+static ssize_t maschine_jam_debugfs_capture_read(struct file *file, char __user *buf, size_t count, loff_t *ppos){
+	struct maschine_jam_driver_data *driver_data = file->private_data;
+	unsigned int copied;
+	int error_code;
+
+	if ((file->f_flags & O_NONBLOCK) && kfifo_is_empty(&driver_data->capture_ring) && test_bit(MJ_CAPTURE_ENABLED, &driver_data->capture_flags)){
+		return -EAGAIN;
+	}
+	error_code = wait_event_interruptible(driver_data->capture_wait,
+		!kfifo_is_empty(&driver_data->capture_ring) || !test_bit(MJ_CAPTURE_ENABLED, &driver_data->capture_flags) ||
+		test_bit(MJ_CAPTURE_SHUTDOWN, &driver_data->capture_flags));
+	if (error_code != 0){
+		return error_code;
+	}
+	if (mutex_lock_interruptible(&driver_data->capture_mutex) != 0){
+		return -ERESTARTSYS;
+	}
+	error_code = kfifo_to_user(&driver_data->capture_ring, buf, count, &copied);
+	mutex_unlock(&driver_data->capture_mutex);
+	return error_code != 0 ? error_code : copied;
+}
+static ssize_t maschine_jam_debugfs_capture_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos){
+	struct maschine_jam_driver_data *driver_data = file->private_data;
+	unsigned long flags;
+	bool enable;
+	int error_code;
+
+	error_code = kstrtobool_from_user(buf, count, &enable);
+	if (error_code != 0){
+		return error_code;
+	}
+	mutex_lock(&driver_data->capture_mutex);
+	if (enable && test_bit(MJ_CAPTURE_SHUTDOWN, &driver_data->capture_flags)){
+		error_code = -ENODEV;
+	} else if (enable && !kfifo_initialized(&driver_data->capture_ring)){
+		// allocated by the first capture, kept until the device is removed
+		error_code = kfifo_alloc(&driver_data->capture_ring, MASCHINE_JAM_CAPTURE_RING_BYTES, GFP_KERNEL);
+	}
+	if (error_code == 0){
+		spin_lock_irqsave(&driver_data->capture_lock, flags);
+		if (enable && !test_bit(MJ_CAPTURE_ENABLED, &driver_data->capture_flags)){
+			kfifo_reset(&driver_data->capture_ring);
+			set_bit(MJ_CAPTURE_ENABLED, &driver_data->capture_flags);
+		} else if (!enable){
+			clear_bit(MJ_CAPTURE_ENABLED, &driver_data->capture_flags);
+		}
+		spin_unlock_irqrestore(&driver_data->capture_lock, flags);
+		wake_up_interruptible(&driver_data->capture_wait);
+	} else if (error_code == -ENOMEM){
+		printk(KERN_ALERT "Failed to allocate capture ring.\n");
+	}
+	mutex_unlock(&driver_data->capture_mutex);
+	return error_code != 0 ? error_code : count;
+}
+static const struct file_operations maschine_jam_debugfs_capture_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = maschine_jam_debugfs_capture_read,
+	.write = maschine_jam_debugfs_capture_write,
+};
+// Writing a capture stream to replay feeds it through maschine_jam_raw_event, paced by the
+// recorded timestamps divided by replay_speed (0 feeds it as fast as the writes arrive).
+// Each open of replay starts a new session, only one session can be open at a time.
+static int maschine_jam_replay_record(struct maschine_jam_driver_data *driver_data){
+	struct maschine_jam_capture_header *header = (struct maschine_jam_capture_header *)driver_data->replay_record;
+	uint8_t *data = &driver_data->replay_record[sizeof(struct maschine_jam_capture_header)];
+	u64 timestamp_ns = le64_to_cpu(header->timestamp_ns);
+	u32 replay_speed = READ_ONCE(driver_data->replay_speed);
+	struct hid_report *report;
+	ktime_t deadline;
+	int error_code;
+
+	if (!driver_data->replay_started){
+		driver_data->replay_first_timestamp_ns = timestamp_ns;
+		driver_data->replay_start = ktime_get();
+		driver_data->replay_started = true;
+	}
+	if (replay_speed != 0 && timestamp_ns > driver_data->replay_first_timestamp_ns){
+		// deadlines are relative to the session start, so sleep overshoot does not accumulate
+		deadline = ktime_add_ns(driver_data->replay_start, div_u64(timestamp_ns - driver_data->replay_first_timestamp_ns, replay_speed));
+		if (ktime_before(ktime_get(), deadline)){
+			error_code = wait_event_interruptible_hrtimeout(driver_data->capture_wait,
+				test_bit(MJ_CAPTURE_SHUTDOWN, &driver_data->capture_flags), ktime_sub(deadline, ktime_get()));
+			if (error_code != -ETIME && error_code != 0){
+				return error_code;
+			}
+		}
+	}
+	if (test_bit(MJ_CAPTURE_SHUTDOWN, &driver_data->capture_flags)){
+		return -ENODEV;
+	}
+	report = driver_data->mj_hid_device->report_enum[HID_INPUT_REPORT].report_id_hash[data[0]];
+	if (report == NULL){
+		printk(KERN_ALERT "maschine_jam_replay_record() - error - report id 0x%02x is not an input report\n", data[0]);
+		return -EINVAL;
+	}
+	maschine_jam_raw_event(driver_data->mj_hid_device, report, data, header->size);
+	this_cpu_inc(driver_data->stats->replay_reports);
+	return 0;
+}
+static int maschine_jam_debugfs_replay_open(struct inode *inode, struct file *file){
+	struct maschine_jam_driver_data *driver_data = inode->i_private;
+
+	if (test_and_set_bit(MJ_REPLAY_ACTIVE, &driver_data->capture_flags)){
+		return -EBUSY;
+	}
+	driver_data->replay_record_length = 0;
+	driver_data->replay_started = false;
+	file->private_data = driver_data;
+	return nonseekable_open(inode, file);
+}
+static int maschine_jam_debugfs_replay_release(struct inode *inode, struct file *file){
+	struct maschine_jam_driver_data *driver_data = file->private_data;
+
+	clear_bit(MJ_REPLAY_ACTIVE, &driver_data->capture_flags);
+	return 0;
+}
+static ssize_t maschine_jam_debugfs_replay_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos){
+	struct maschine_jam_driver_data *driver_data = file->private_data;
+	struct maschine_jam_capture_header *header = (struct maschine_jam_capture_header *)driver_data->replay_record;
+	size_t consumed = 0;
+	size_t record_length, chunk;
+	int error_code = 0;
+
+	if (mutex_lock_interruptible(&driver_data->replay_mutex) != 0){
+		return -ERESTARTSYS;
+	}
+	// records may be split across writes, the partial one is kept in replay_record
+	while (consumed < count && error_code == 0){
+		record_length = sizeof(struct maschine_jam_capture_header);
+		if (driver_data->replay_record_length >= sizeof(struct maschine_jam_capture_header)){
+			record_length += header->size;
+		}
+		chunk = min_t(size_t, record_length - driver_data->replay_record_length, count - consumed);
+		if (copy_from_user(&driver_data->replay_record[driver_data->replay_record_length], buf + consumed, chunk) != 0){
+			error_code = -EFAULT;
+			break;
+		}
+		driver_data->replay_record_length += chunk;
+		consumed += chunk;
+		if (driver_data->replay_record_length == sizeof(struct maschine_jam_capture_header)){
+			if (header->size == 0 || header->size > MASCHINE_JAM_CAPTURE_REPORT_MAX_BYTES){
+				printk(KERN_ALERT "maschine_jam_debugfs_replay_write() - error - bad record size %u\n", header->size);
+				driver_data->replay_record_length = 0;
+				error_code = -EINVAL;
+			}
+		} else if (driver_data->replay_record_length == record_length){
+			driver_data->replay_record_length = 0;
+			error_code = maschine_jam_replay_record(driver_data);
+		}
+	}
+	mutex_unlock(&driver_data->replay_mutex);
+	return error_code != 0 ? error_code : consumed;
+}
+static const struct file_operations maschine_jam_debugfs_replay_fops = {
+	.owner = THIS_MODULE,
+	.open = maschine_jam_debugfs_replay_open,
+	.release = maschine_jam_debugfs_replay_release,
+	.write = maschine_jam_debugfs_replay_write,
+};
+// debugfs is diagnostics only, a failure to create it never fails the probe
+static void maschine_jam_create_debugfs_interface(struct maschine_jam_driver_data *driver_data){
+	char directory_name[64];
+
+	snprintf(directory_name, sizeof(directory_name), "maschine_jam-%s", dev_name(&driver_data->mj_hid_device->dev));
+	driver_data->debugfs_directory = debugfs_create_dir(directory_name, NULL);
+	debugfs_create_file("stats", MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS, driver_data->debugfs_directory, driver_data, &maschine_jam_debugfs_stats_fops);
+	debugfs_create_file("input_latency", MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS, driver_data->debugfs_directory, driver_data, &maschine_jam_debugfs_input_latency_fops);
+	debugfs_create_file("output_latency", MASCHINE_JAM_SYSFS_READ_ONLY_ATTRIBUTE_PERMISSIONS, driver_data->debugfs_directory, driver_data, &maschine_jam_debugfs_output_latency_fops);
+	debugfs_create_file("capture", MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS, driver_data->debugfs_directory, driver_data, &maschine_jam_debugfs_capture_fops);
+	debugfs_create_file("replay", MASCHINE_JAM_SYSFS_WRITE_ONLY_ATTRIBUTE_PERMISSIONS, driver_data->debugfs_directory, driver_data, &maschine_jam_debugfs_replay_fops);
+	debugfs_create_u32("replay_speed", MASCHINE_JAM_SYSFS_ATTRIBUTE_PERMISSIONS, driver_data->debugfs_directory, &driver_data->replay_speed);
+}
+static void maschine_jam_delete_debugfs_interface(struct maschine_jam_driver_data *driver_data){
+	// removal waits for readers and writers of the files, do not leave them blocked
+	set_bit(MJ_CAPTURE_SHUTDOWN, &driver_data->capture_flags);
+	wake_up_interruptible(&driver_data->capture_wait);
+	debugfs_remove_recursive(driver_data->debugfs_directory);
+	driver_data->debugfs_directory = NULL;
+}
+
+// Mapping and LED state of removed units, keyed by serial number (the HID uniq string), so a unit
+// that drops off the bus comes back mapped and lit. Entries are kept until the module unloads.
+struct maschine_jam_state_cache_entry {
+	struct list_head list;
+	char uniq[sizeof_field(struct hid_device, uniq)];
+	struct maschine_jam_profile mapping;
+	uint8_t hid_report_led_buttons[MASCHINE_JAM_NUMBER_BUTTON_LEDS];
+	uint8_t hid_report_led_pads[MASCHINE_JAM_NUMBER_PAD_LEDS];
+	uint8_t hid_report_led_smartstrips[MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS];
+	struct maschine_jam_smartstrip_display_state hid_report_led_smartstrips_display_states[MASCHINE_JAM_NUMBER_SMARTSTRIPS];
+};
+static LIST_HEAD(maschine_jam_state_cache);
+static DEFINE_MUTEX(maschine_jam_state_cache_mutex);
+// must hold maschine_jam_state_cache_mutex
+static struct maschine_jam_state_cache_entry* maschine_jam_state_cache_find(const char *uniq){
+	struct maschine_jam_state_cache_entry *entry;
+
+	list_for_each_entry(entry, &maschine_jam_state_cache, list){
+		if (strcmp(entry->uniq, uniq) == 0){
+			return entry;
+		}
+	}
+	return NULL;
+}
+// called from remove once the sound card is gone, nothing changes the mapping or LEDs anymore
+static void maschine_jam_state_cache_save(struct maschine_jam_driver_data *driver_data){
+	const char *uniq = driver_data->mj_hid_device->uniq;
+	struct maschine_jam_state_cache_entry *entry;
+
+	if (uniq[0] == '\0'){
+		return;
+	}
+	mutex_lock(&maschine_jam_state_cache_mutex);
+	entry = maschine_jam_state_cache_find(uniq);
+	if (entry == NULL){
+		entry = kzalloc(sizeof(struct maschine_jam_state_cache_entry), GFP_KERNEL);
+		if (entry == NULL){
+			printk(KERN_ALERT "Failed to allocate state cache entry, the state of %s is lost.\n", uniq);
+			goto unlock_state_cache_mutex;
+		}
+		strscpy(entry->uniq, uniq, sizeof(entry->uniq));
+		list_add(&entry->list, &maschine_jam_state_cache);
+	}
+	mutex_lock(&driver_data->midi_out_mapping_mutex);
+	maschine_jam_profile_snapshot(driver_data, &entry->mapping);
+	mutex_unlock(&driver_data->midi_out_mapping_mutex);
+	memcpy(entry->hid_report_led_buttons, driver_data->hid_report_led_buttons, sizeof(entry->hid_report_led_buttons));
+	memcpy(entry->hid_report_led_pads, driver_data->hid_report_led_pads, sizeof(entry->hid_report_led_pads));
+	memcpy(entry->hid_report_led_smartstrips, driver_data->hid_report_led_smartstrips, sizeof(entry->hid_report_led_smartstrips));
+	memcpy(entry->hid_report_led_smartstrips_display_states, driver_data->hid_report_led_smartstrips_display_states, sizeof(entry->hid_report_led_smartstrips_display_states));
+unlock_state_cache_mutex:
+	mutex_unlock(&maschine_jam_state_cache_mutex);
+}
+// called from probe before the routing table is built, returns true if a saved state was restored
+static bool maschine_jam_state_cache_restore(struct maschine_jam_driver_data *driver_data){
+	const char *uniq = driver_data->mj_hid_device->uniq;
+	struct maschine_jam_state_cache_entry *entry;
+
+	if (uniq[0] == '\0'){
+		return false;
+	}
+	mutex_lock(&maschine_jam_state_cache_mutex);
+	entry = maschine_jam_state_cache_find(uniq);
+	if (entry != NULL){
+		memcpy(driver_data->inputs.midi_in_knob_configs, entry->mapping.midi_in_knob_configs, sizeof(driver_data->inputs.midi_in_knob_configs));
+		memcpy(driver_data->inputs.midi_in_button_configs, entry->mapping.midi_in_button_configs, sizeof(driver_data->inputs.midi_in_button_configs));
+		memcpy(driver_data->inputs.midi_in_smartstrip_configs, entry->mapping.midi_in_smartstrip_configs, sizeof(driver_data->inputs.midi_in_smartstrip_configs));
+		memcpy(driver_data->midi_out_button_led_nodes, entry->mapping.midi_out_button_led_nodes, sizeof(driver_data->midi_out_button_led_nodes));
+		memcpy(driver_data->midi_out_pad_led_nodes, entry->mapping.midi_out_pad_led_nodes, sizeof(driver_data->midi_out_pad_led_nodes));
+		memcpy(driver_data->midi_out_smartstrip_led_nodes, entry->mapping.midi_out_smartstrip_led_nodes, sizeof(driver_data->midi_out_smartstrip_led_nodes));
+		memcpy(driver_data->hid_report_led_buttons, entry->hid_report_led_buttons, sizeof(driver_data->hid_report_led_buttons));
+		memcpy(driver_data->hid_report_led_pads, entry->hid_report_led_pads, sizeof(driver_data->hid_report_led_pads));
+		memcpy(driver_data->hid_report_led_smartstrips, entry->hid_report_led_smartstrips, sizeof(driver_data->hid_report_led_smartstrips));
+		memcpy(driver_data->hid_report_led_smartstrips_display_states, entry->hid_report_led_smartstrips_display_states, sizeof(driver_data->hid_report_led_smartstrips_display_states));
+	}
+	mutex_unlock(&maschine_jam_state_cache_mutex);
+	return entry != NULL;
+}
+static void maschine_jam_state_cache_free(void){
+	struct maschine_jam_state_cache_entry *entry, *next;
+
+	mutex_lock(&maschine_jam_state_cache_mutex);
+	list_for_each_entry_safe(entry, next, &maschine_jam_state_cache, list){
+		list_del(&entry->list);
+		kfree(entry);
+	}
+	mutex_unlock(&maschine_jam_state_cache_mutex);
+}
+// send all three LED reports in the next frame, whatever the device showed before
+static void maschine_jam_led_repaint(struct maschine_jam_driver_data *driver_data){
+	unsigned long flags;
+
+	spin_lock_irqsave(&driver_data->hid_report_led_buttons_lock, flags);
+	maschine_jam_hid_output_report_mark_dirty(&driver_data->hid_report_led_buttons_output);
+	spin_unlock_irqrestore(&driver_data->hid_report_led_buttons_lock, flags);
+	spin_lock_irqsave(&driver_data->hid_report_led_pads_lock, flags);
+	maschine_jam_hid_output_report_mark_dirty(&driver_data->hid_report_led_pads_output);
+	spin_unlock_irqrestore(&driver_data->hid_report_led_pads_lock, flags);
+	spin_lock_irqsave(&driver_data->hid_report_led_smartstrips_lock, flags);
+	maschine_jam_hid_output_report_mark_dirty(&driver_data->hid_report_led_smartstrips_output);
+	spin_unlock_irqrestore(&driver_data->hid_report_led_smartstrips_lock, flags);
+	maschine_jam_led_frame_request(driver_data);
+}
+
 static int maschine_jam_probe(struct hid_device *mj_hid_device, const struct hid_device_id *id){
 	int error_code;
-	struct usb_interface *intface = to_usb_interface(mj_hid_device->dev.parent);
-	unsigned short interface_number = intface->cur_altsetting->desc.bInterfaceNumber;
+	unsigned int connect_mask;
+	bool state_restored;
+	struct usb_interface *intface;
+	unsigned short interface_number;
 	//unsigned long dd = id->driver_data;
 	struct maschine_jam_driver_data *driver_data = NULL;
 
 	printk(KERN_ALERT "Found Maschine JAM!\n");
-	if (interface_number != 0){
-		printk(KERN_ALERT "Unexpected interface number %d was found. Unit may be in update mode.", interface_number);
-		error_code = -EBADR; /* Interface 1 is the Device Firmware Upgrade Interface */
-		goto return_error_code;
+	// Only a real unit has a USB parent; a uhid emulated one (tools/maschine-jam-emulator) does not.
+	if (hid_is_usb(mj_hid_device)){
+		intface = to_usb_interface(mj_hid_device->dev.parent);
+		interface_number = intface->cur_altsetting->desc.bInterfaceNumber;
+		if (interface_number != 0){
+			printk(KERN_ALERT "Unexpected interface number %d was found. Unit may be in update mode.", interface_number);
+			error_code = -EBADR; /* Interface 1 is the Device Firmware Upgrade Interface */
+			goto return_error_code;
+		}
 	}
 
 	driver_data = kzalloc(sizeof(struct maschine_jam_driver_data), GFP_KERNEL);
@@ -2671,25 +4165,50 @@ static int maschine_jam_probe(struct hid_device *mj_hid_device, const struct hid
 		goto return_error_code;
 	}
 	maschine_jam_initialize_driver_data(driver_data, mj_hid_device);
-	error_code = snd_midi_event_new(128, &driver_data->midi_in_decoder);
-	if (error_code == 0) {
-		snd_midi_event_reset_decode(driver_data->midi_in_decoder);
-		snd_midi_event_no_status(driver_data->midi_in_decoder, 0);
-	} else {
-		printk(KERN_ALERT "Failed to create new midi encoder!\n");
+	// a mapping saved for this serial number wins over the built-in profile
+	kernel_param_lock(THIS_MODULE);
+	maschine_jam_builtin_profile_apply(driver_data, builtin_profile_name);
+	kernel_param_unlock(THIS_MODULE);
+	state_restored = maschine_jam_state_cache_restore(driver_data);
+	driver_data->stats = alloc_percpu(struct maschine_jam_stats);
+	if (driver_data->stats == NULL) {
+		printk(KERN_ALERT "Failed to allocate statistics.\n");
+		error_code = -ENOMEM;
 		goto failure_free_driver_data;
 	}
-	error_code = snd_midi_event_new(128, &driver_data->midi_out_encoder);
-	if (error_code == 0) {
-		snd_midi_event_reset_encode(driver_data->midi_out_encoder);
-	} else {
-		printk(KERN_ALERT "Failed to create new midi decoder!\n");
-		goto failure_free_midi_encoder;
+	error_code = maschine_jam_create_hid_output_reports(driver_data);
+	if (error_code != 0) {
+		printk(KERN_ALERT "Failed to allocate hid output reports.\n");
+		goto failure_free_stats;
+	}
+	mutex_lock(&driver_data->midi_out_mapping_mutex);
+	error_code = maschine_jam_midi_out_routing_table_update(driver_data);
+	mutex_unlock(&driver_data->midi_out_mapping_mutex);
+	if (error_code != 0) {
+		printk(KERN_ALERT "Failed to build midi out routing table.\n");
+		goto failure_delete_hid_output_reports;
+	}
+	driver_data->led_workqueue = alloc_workqueue("maschine_jam_led_%s", WQ_HIGHPRI, 1, dev_name(&mj_hid_device->dev));
+	if (driver_data->led_workqueue == NULL) {
+		printk(KERN_ALERT "Failed to allocate led workqueue.\n");
+		error_code = -ENOMEM;
+		goto failure_free_midi_out_routing_table;
+	}
+	error_code = kfifo_alloc(&driver_data->input_ring, clamp_t(unsigned int, input_ring_depth, MASCHINE_JAM_INPUT_RING_DEPTH_MIN, MASCHINE_JAM_INPUT_RING_DEPTH_MAX), GFP_KERNEL);
+	if (error_code != 0) {
+		printk(KERN_ALERT "Failed to allocate input ring.\n");
+		goto failure_destroy_led_workqueue;
+	}
+	driver_data->input_workqueue = alloc_workqueue("maschine_jam_input_%s", WQ_HIGHPRI, 1, dev_name(&mj_hid_device->dev));
+	if (driver_data->input_workqueue == NULL) {
+		printk(KERN_ALERT "Failed to allocate input workqueue.\n");
+		error_code = -ENOMEM;
+		goto failure_free_input_ring;
 	}
 	error_code = maschine_jam_create_sound_card(driver_data);
 	if (error_code != 0){
 		printk(KERN_ALERT "Failed to create sound card.\n");
-		goto failure_free_midi_decoder;
+		goto failure_destroy_input_workqueue;
 	}
 	error_code = maschine_jam_create_sysfs_inputs_interface(driver_data);
 	if (error_code != 0){
@@ -2701,6 +4220,12 @@ static int maschine_jam_probe(struct hid_device *mj_hid_device, const struct hid
 		printk(KERN_ALERT "Failed to create sysfs outputs interface attributes.\n");
 		goto failure_delete_sysfs_inputs_interface;
 	}
+	error_code = maschine_jam_create_sysfs_profile_interface(driver_data);
+	if (error_code != 0){
+		printk(KERN_ALERT "Failed to create sysfs profile attribute.\n");
+		goto failure_delete_sysfs_outputs_interface;
+	}
+	maschine_jam_create_debugfs_interface(driver_data);
 
 	hid_set_drvdata(mj_hid_device, driver_data);
 
@@ -2708,33 +4233,58 @@ static int maschine_jam_probe(struct hid_device *mj_hid_device, const struct hid
 	error_code = hid_parse(mj_hid_device);
 	if (error_code != 0) {
 		printk(KERN_ALERT "hid parse failed\n");
-		goto failure_delete_sysfs_outputs_interface;
+		goto failure_delete_sysfs_profile_interface;
+	}
+	connect_mask = generic_hid ? HID_CONNECT_DEFAULT : HID_CONNECT_HIDRAW;
+	if (connect_mask == HID_CONNECT_HIDRAW && !IS_ENABLED(CONFIG_HIDRAW)) {
+		// nothing claims the device, the start still succeeds because of raw_event
+		printk(KERN_NOTICE "hidraw is not available, the HID core parses every report\n");
 	}
-	error_code = hid_hw_start(mj_hid_device, HID_CONNECT_DEFAULT);
+	error_code = hid_hw_start(mj_hid_device, connect_mask);
 	if (error_code != 0) {
 		printk(KERN_ALERT "hw start failed\n");
-		goto failure_delete_sysfs_outputs_interface;
+		goto failure_delete_sysfs_profile_interface;
 	}
 	error_code = hid_hw_open(mj_hid_device);
 	if (error_code != 0) {
 		printk(KERN_ALERT "hw open failed\n");
 		goto failure_hid_hw_stop;
 	}
+	if (state_restored){
+		printk(KERN_NOTICE "Restored mapping and LEDs of %s.\n", mj_hid_device->uniq);
+		maschine_jam_led_repaint(driver_data);
+	}
 
 	goto return_error_code;
 
 failure_hid_hw_stop:
 	hid_hw_stop(mj_hid_device);
+failure_delete_sysfs_profile_interface:
+	maschine_jam_delete_debugfs_interface(driver_data);
+	kfifo_free(&driver_data->capture_ring);
+	maschine_jam_delete_sysfs_profile_interface(driver_data);
+	cancel_work_sync(&driver_data->input_work);
 failure_delete_sysfs_outputs_interface:
 	maschine_jam_delete_sysfs_outputs_interface(driver_data);
 failure_delete_sysfs_inputs_interface:
 	maschine_jam_delete_sysfs_inputs_interface(driver_data);
 failure_delete_sound_card:
 	maschine_jam_delete_sound_card(driver_data);
-failure_free_midi_decoder:
-	snd_midi_event_free(driver_data->midi_out_encoder);
-failure_free_midi_encoder:
-	snd_midi_event_free(driver_data->midi_in_decoder);
+	maschine_jam_stop_hid_output_reports(driver_data);
+	hrtimer_cancel(&driver_data->led_frame_timer);
+	cancel_work_sync(&driver_data->led_frame_work);
+failure_destroy_input_workqueue:
+	destroy_workqueue(driver_data->input_workqueue);
+failure_free_input_ring:
+	kfifo_free(&driver_data->input_ring);
+failure_destroy_led_workqueue:
+	destroy_workqueue(driver_data->led_workqueue);
+failure_free_midi_out_routing_table:
+	maschine_jam_midi_out_routing_table_free(driver_data);
+failure_delete_hid_output_reports:
+	maschine_jam_delete_hid_output_reports(driver_data);
+failure_free_stats:
+	free_percpu(driver_data->stats);
 failure_free_driver_data:
 	kfree(driver_data);
 return_error_code:
@@ -2749,11 +4299,24 @@ static void maschine_jam_remove(struct hid_device *mj_hid_device){
 		driver_data = hid_get_drvdata(mj_hid_device);
 
 		hid_hw_stop(mj_hid_device);
+		// a replay and a profile write also queue the input work, end them before cancelling it
+		maschine_jam_delete_debugfs_interface(driver_data);
+		kfifo_free(&driver_data->capture_ring);
+		maschine_jam_delete_sysfs_profile_interface(driver_data);
+		cancel_work_sync(&driver_data->input_work);
 		maschine_jam_delete_sound_card(driver_data);
 		maschine_jam_delete_sysfs_inputs_interface(driver_data);
 		maschine_jam_delete_sysfs_outputs_interface(driver_data);
-		snd_midi_event_free(driver_data->midi_out_encoder);
-		snd_midi_event_free(driver_data->midi_in_decoder);
+		maschine_jam_state_cache_save(driver_data);
+		maschine_jam_stop_hid_output_reports(driver_data);
+		hrtimer_cancel(&driver_data->led_frame_timer);
+		cancel_work_sync(&driver_data->led_frame_work);
+		destroy_workqueue(driver_data->led_workqueue);
+		destroy_workqueue(driver_data->input_workqueue);
+		kfifo_free(&driver_data->input_ring);
+		maschine_jam_midi_out_routing_table_free(driver_data);
+		maschine_jam_delete_hid_output_reports(driver_data);
+		free_percpu(driver_data->stats);
 		kfree(driver_data);
 	}
 
@@ -2774,10 +4337,19 @@ MODULE_DEVICE_TABLE(hid, maschine_jam_devices);
 static struct hid_driver maschine_jam_driver = {
 	.name = "maschine-jam",
 	.id_table = maschine_jam_devices,
-	.raw_event = maschine_jam_raw_event,
+	.raw_event = maschine_jam_hid_raw_event,
 	.probe = maschine_jam_probe,
 	.remove = maschine_jam_remove,
 };
-module_hid_driver(maschine_jam_driver);
+
+static int __init maschine_jam_init(void){
+	return hid_register_driver(&maschine_jam_driver);
+}
+static void __exit maschine_jam_exit(void){
+	hid_unregister_driver(&maschine_jam_driver);
+	maschine_jam_state_cache_free();
+}
+module_init(maschine_jam_init);
+module_exit(maschine_jam_exit);
 
 MODULE_LICENSE("GPL");
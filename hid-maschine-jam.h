@@ -0,0 +1,96 @@
+#ifndef _HID_MASCHINE_JAM_H
+#define _HID_MASCHINE_JAM_H
+
+#include <linux/types.h>
+
+// Report layout, input configs and the translation and rendering cores, shared with the KUnit
+// suite in hid-maschine-jam-test.c.
+#define MASCHINE_JAM_HID_REPORT_ID_BYTES 1
+#define MASCHINE_JAM_NUMBER_KNOBS 2
+#define MASCHINE_JAM_HID_REPORT_01_KNOB_BITS 4
+#define MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES (MASCHINE_JAM_NUMBER_KNOBS * MASCHINE_JAM_HID_REPORT_01_KNOB_BITS) / 8 // 1
+#define MASCHINE_JAM_NUMBER_BUTTONS 120
+#define MASCHINE_JAM_HID_REPORT_01_BUTTON_BITS 1
+#define MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES (MASCHINE_JAM_NUMBER_BUTTONS * MASCHINE_JAM_HID_REPORT_01_BUTTON_BITS) / 8 // 15
+#define MASCHINE_JAM_HID_REPORT_01_DATA_BYTES (MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES + MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES) // 16
+#define MASCHINE_JAM_HID_REPORT_01_BYTES (MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_HID_REPORT_01_DATA_BYTES) // 17
+#define MASCHINE_JAM_NUMBER_SMARTSTRIPS 8
+#define MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS 2
+enum maschine_jam_smartstrip_finger_mode{
+	MJ_SMARTSTRIP_FINGER_MODE_TOUCH = 0,
+	MJ_SMARTSTRIP_FINGER_MODE_SLIDE = 1
+};
+#define MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES 2
+#define MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_TIMESTAMP_BITS 16
+#define MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_TOUCH_VALUE_BITS 16
+#define MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_BITS (MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_TIMESTAMP_BITS + (MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_TOUCH_VALUE_BITS * 2)) // 48
+#define MASCHINE_JAM_HID_REPORT_02_SMARTSTRIPS_BYTES (MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_HID_REPORT_02_SMARTSTRIP_BITS) / 8 // 48
+#define MASCHINE_JAM_HID_REPORT_02_DATA_BYTES (MASCHINE_JAM_HID_REPORT_02_SMARTSTRIPS_BYTES) // 48
+#define MASCHINE_JAM_HID_REPORT_02_BYTES (MASCHINE_JAM_HID_REPORT_ID_BYTES + MASCHINE_JAM_HID_REPORT_02_DATA_BYTES) // 49
+
+#define MASCHINE_JAM_HID_INPUT_REPORT_MAX_BYTES MASCHINE_JAM_HID_REPORT_02_BYTES
+#define MASCHINE_JAM_SYSEX_MAX_LENGTH 28
+#define MASCHINE_JAM_MIDI_MESSAGE_MAX_LENGTH 3
+// Worst case for one report: every knob and button of report 0x01 changes, plus the shift sysex.
+#define MASCHINE_JAM_MIDI_IN_REPORT_MAX_BYTES (((MASCHINE_JAM_NUMBER_KNOBS + MASCHINE_JAM_NUMBER_BUTTONS) * MASCHINE_JAM_MIDI_MESSAGE_MAX_LENGTH) + MASCHINE_JAM_SYSEX_MAX_LENGTH)
+// Worst case for a resync: every button held and every smartstrip finger touching, plus the shift sysex.
+#define MASCHINE_JAM_MIDI_IN_RESYNC_MAX_BYTES (((MASCHINE_JAM_NUMBER_BUTTONS + (MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS * MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES)) * MASCHINE_JAM_MIDI_MESSAGE_MAX_LENGTH) + MASCHINE_JAM_SYSEX_MAX_LENGTH)
+#define MASCHINE_JAM_MIDI_IN_BUFFER_BYTES (MASCHINE_JAM_MIDI_IN_RESYNC_MAX_BYTES > MASCHINE_JAM_MIDI_IN_REPORT_MAX_BYTES ? MASCHINE_JAM_MIDI_IN_RESYNC_MAX_BYTES : MASCHINE_JAM_MIDI_IN_REPORT_MAX_BYTES)
+enum maschine_jam_midi_type{
+	MJ_MIDI_TYPE_NOTE,
+	MJ_MIDI_TYPE_AFTERTOUCH,
+	MJ_MIDI_TYPE_CONTROL_CHANGE,
+	MJ_MIDI_TYPE_SYSEX
+};
+#define MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP 11
+#define MASCHINE_JAM_NUMBER_SMARTSTRIP_LEDS (MASCHINE_JAM_NUMBER_SMARTSTRIPS * MASCHINE_JAM_NUMBER_LEDS_PER_SMARTSTRIP)
+
+struct maschine_jam_midi_config {
+	enum maschine_jam_midi_type type;
+	uint8_t channel; // lower nibble 0-15
+	uint8_t key; // 0-127
+	uint8_t value_min; // 0
+	uint8_t value_max; // 127
+	// Wire format status and data 1 bytes, rebuilt by maschine_jam_midi_config_compile whenever
+	// type, channel or key change. A zero status means the config produces no message.
+	uint8_t status;
+	uint8_t data1;
+};
+
+enum maschine_jam_smartstrip_display_mode{
+	MJ_SMARTSTRIP_DISPLAY_MODE_SINGLE = 0x00,
+	MJ_SMARTSTRIP_DISPLAY_MODE_DOT = 0x01,
+	MJ_SMARTSTRIP_DISPLAY_MODE_PAN = 0x02,
+	MJ_SMARTSTRIP_DISPLAY_MODE_DUAL = 0x03,
+};
+struct maschine_jam_smartstrip_display_state {
+	enum maschine_jam_smartstrip_display_mode mode;
+	uint8_t color;
+	uint8_t value;
+};
+
+// What the report to MIDI translation reads and updates: the input configs and the cached state
+// of the last report 0x01 and 0x02.
+struct maschine_jam_inputs {
+	struct maschine_jam_midi_config	midi_in_knob_configs[MASCHINE_JAM_NUMBER_KNOBS];
+	uint8_t					hid_report01_data_knobs[MASCHINE_JAM_HID_REPORT_01_KNOBS_BYTES];
+	struct maschine_jam_midi_config	midi_in_button_configs[MASCHINE_JAM_NUMBER_BUTTONS];
+	uint8_t					hid_report01_data_buttons[MASCHINE_JAM_HID_REPORT_01_BUTTONS_BYTES];
+	struct maschine_jam_midi_config	midi_in_smartstrip_configs[MASCHINE_JAM_NUMBER_SMARTSTRIPS][MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS][MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGER_MODES];
+	uint8_t					hid_report02_data_smartstrips[MASCHINE_JAM_HID_REPORT_02_BYTES];
+};
+// MIDI bytes decoded from one report, handed to rawmidi in one piece.
+struct maschine_jam_midi_in_staging {
+	uint8_t					running_status;
+	uint8_t					buffer[MASCHINE_JAM_MIDI_IN_BUFFER_BYTES];
+	unsigned int			length;
+};
+
+#if IS_ENABLED(CONFIG_KUNIT)
+void maschine_jam_initialize_inputs(struct maschine_jam_inputs *inputs);
+void maschine_jam_translate_input_report(struct maschine_jam_inputs *inputs, struct maschine_jam_midi_in_staging *staging, uint8_t *data);
+void maschine_jam_stage_resync_midi_in(struct maschine_jam_inputs *inputs, struct maschine_jam_midi_in_staging *staging);
+bool maschine_jam_render_smartstrip_leds(struct maschine_jam_smartstrip_display_state* smartstrip_display_states, uint8_t *smartstrip_leds);
+#endif
+
+#endif
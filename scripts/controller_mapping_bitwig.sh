@@ -17,6 +17,12 @@ if [ ! -d "$MASCHINE_JAM_SYSFS_DIR" ]; then
 	exit 2
 fi
 
+# The mapping is collected into one profile and written to the profile attribute at the end,
+# so the driver switches to it in one step.
+PROFILE_FILE="$(mktemp)"
+trap 'rm -f "$PROFILE_FILE"' EXIT
+echo "maschine_jam_profile 1" > "$PROFILE_FILE"
+
 midi_map_io(){
 	if [ $# -ne 4 ]; then
 		echo "Incorrect number of parameters."
@@ -40,13 +46,11 @@ midi_map_io(){
 		return 4
 	fi
 	IO_KEY="$4"
-	if [ "$IO_KEY" -lt 0 ] || [ "$IO_KEY" -gt 255 ]; then
-		echo "Invalid key of ${IO_KEY} given. Key must be 0-255."
+	if [ "$IO_KEY" -lt 0 ] || [ "$IO_KEY" -gt 127 ]; then
+		echo "Invalid key of ${IO_KEY} given. Key must be 0-127."
 		return 5
 	fi
-	echo "$IO_CHANNEL" > "${IO_DIRECTORY}/channel"
-	echo "$IO_TYPE" > "${IO_DIRECTORY}/type"
-	echo "$IO_KEY" > "${IO_DIRECTORY}/key"
+	echo "${IO_DIRECTORY#${MASCHINE_JAM_SYSFS_DIR}/} ${IO_CHANNEL} ${IO_TYPE} ${IO_KEY}" >> "$PROFILE_FILE"
 
 	NAME="$(basename ${IO_DIRECTORY})"
 	UP_ONE="$(dirname "$IO_DIRECTORY")"
@@ -355,6 +359,8 @@ midi_map_io(){
 		)
 	)
 )
+echo "end" >> "$PROFILE_FILE"
+cat "$PROFILE_FILE" > "${MASCHINE_JAM_SYSFS_DIR}/profile"
 #note = 9
 #aftertouch = 10
 #cc = 11
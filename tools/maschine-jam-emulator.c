@@ -0,0 +1,1027 @@
+// Virtual Maschine Jam for load and latency testing without the hardware.
+//
+// Creates a uhid device with the Maschine Jam ids and report descriptor so hid-maschine-jam
+// binds to it, then streams input reports 0x01/0x02 at a fixed rate and reads the MIDI the
+// driver produces from its rawmidi port. Optionally writes LED notes to the rawmidi port and
+// captures the 0x80/0x81/0x82 output reports the driver sends back.
+//
+// Build with "make emulator", run as root with the module loaded.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <glob.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/uhid.h>
+
+#define MASCHINE_JAM_VENDOR_ID 0x17CC
+#define MASCHINE_JAM_PRODUCT_ID 0x1500
+#define MASCHINE_JAM_NUMBER_KNOBS 2
+#define MASCHINE_JAM_NUMBER_BUTTONS 120
+#define MASCHINE_JAM_SHIFT_BUTTON 105
+#define MASCHINE_JAM_NUMBER_SMARTSTRIPS 8
+#define MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS 2
+#define MASCHINE_JAM_HID_REPORT_01_BYTES 17
+#define MASCHINE_JAM_HID_REPORT_02_BYTES 49
+#define MASCHINE_JAM_HID_REPORT_MAX_BYTES MASCHINE_JAM_HID_REPORT_02_BYTES
+#define MASCHINE_JAM_SMARTSTRIP_BYTES 6
+#define MASCHINE_JAM_SMARTSTRIP_TOUCH_VALUE_MAX 0x3FF
+
+#define EMULATOR_LATENCY_QUEUE_DEPTH 65536
+#define EMULATOR_LATENCY_SAMPLES_MAX (1 << 20)
+#define EMULATOR_SCRIPT_REPORTS_MAX 65536
+#define EMULATOR_DEVICE_WAIT_MS 5000
+
+// Report descriptor as dumped from a real unit, see README.md. 550 bytes.
+static const uint8_t maschine_jam_report_descriptor[] = {
+	0x06, 0x01, 0xFF, // Usage Page (FF01h)
+	0x09, 0x00, // Usage (00h)
+	0xA1, 0x01, // Collection (Application)
+		0x09, 0x01, // Usage (01h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0x01, // Report ID (1)
+			0x09, 0x03, // Usage (03h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x25, 0x0F, // Logical Maximum (15)
+			0x75, 0x04, // Report Size (4)
+			0x95, 0x02, // Report Count (2)
+			0x81, 0x02, // Input (Variable)
+			0x09, 0x02, // Usage (02h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x25, 0x01, // Logical Maximum (1)
+			0x75, 0x01, // Report Size (1)
+			0x95, 0x78, // Report Count (120)
+			0x81, 0x02, // Input (Variable)
+		0xC0, // End Collection
+		0x09, 0x01, // Usage (01h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0x02, // Report ID (2)
+			0x09, 0x44, // Usage (44h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x18, // Report Count (24)
+			0x81, 0x02, // Input (Variable)
+		0xC0, // End Collection
+		0x09, 0x40, // Usage (40h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0x40, // Report ID (64)
+			0x09, 0x41, // Usage (41h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x0C, // Report Count (12)
+			0x81, 0x02, // Input (Variable)
+		0xC0, // End Collection
+		0x09, 0x80, // Usage (80h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0x80, // Report ID (128)
+			0x09, 0x81, // Usage (81h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x25, 0x7F, // Logical Maximum (127)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x25, // Report Count (37)
+			0x91, 0x02, // Output (Variable)
+			0x09, 0x81, // Usage (81h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x25, 0x7F, // Logical Maximum (127)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x10, // Report Count (16)
+			0x91, 0x02, // Output (Variable)
+		0xC0, // End Collection
+		0x09, 0x80, // Usage (80h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0x81, // Report ID (129)
+			0x09, 0x83, // Usage (83h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x25, 0x7F, // Logical Maximum (127)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x50, // Report Count (80)
+			0x91, 0x02, // Output (Variable)
+		0xC0, // End Collection
+		0x09, 0x80, // Usage (80h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0x82, // Report ID (130)
+			0x09, 0x83, // Usage (83h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x25, 0x7F, // Logical Maximum (127)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x58, // Report Count (88)
+			0x91, 0x02, // Output (Variable)
+		0xC0, // End Collection
+		0x09, 0xD0, // Usage (D0h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xD0, // Report ID (208)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x02, // Report Count (2)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x01, // Report Count (1)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x1B, // Report Count (27)
+			0xB1, 0x02, // Feature (Variable)
+		0xC0, // End Collection
+		0x09, 0xD8, // Usage (D8h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xD8, // Report ID (216)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x02, // Report Count (2)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x02, // Report Count (2)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x04, // Report Count (4)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x0C, // Report Count (12)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x02, // Report Count (2)
+			0xB1, 0x02, // Feature (Variable)
+		0xC0, // End Collection
+		0x09, 0xD8, // Usage (D8h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xD9, // Report ID (217)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x20, // Report Count (32)
+			0xB1, 0x03, // Feature (Constant, Variable)
+		0xC0, // End Collection
+		0x09, 0xD8, // Usage (D8h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xDA, // Report ID (218)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x18, // Report Count (24)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x04, // Report Count (4)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x02, // Report Count (2)
+			0xB1, 0x02, // Feature (Variable)
+		0xC0, // End Collection
+		0x09, 0xD8, // Usage (D8h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xDB, // Report ID (219)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x18, // Report Count (24)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x04, // Report Count (4)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x02, // Report Count (2)
+			0xB1, 0x02, // Feature (Variable)
+		0xC0, // End Collection
+		0x09, 0xD8, // Usage (D8h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xDC, // Report ID (220)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x18, // Report Count (24)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x04, // Report Count (4)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x02, // Report Count (2)
+			0xB1, 0x02, // Feature (Variable)
+		0xC0, // End Collection
+		0x09, 0xD8, // Usage (D8h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xDD, // Report ID (221)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x18, // Report Count (24)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x04, // Report Count (4)
+			0xB1, 0x02, // Feature (Variable)
+			0x09, 0xD1, // Usage (D1h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x27, 0xFF, 0xFF, 0x00, 0x00, // Logical Maximum (65535)
+			0x75, 0x10, // Report Size (16)
+			0x95, 0x02, // Report Count (2)
+			0xB1, 0x02, // Feature (Variable)
+		0xC0, // End Collection
+		0x09, 0xF0, // Usage (F0h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xF1, // Report ID (241)
+			0x09, 0x81, // Usage (81h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x25, 0x7F, // Logical Maximum (127)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0xCC, // Report Count (204)
+			0xB1, 0x02, // Feature (Variable)
+		0xC0, // End Collection
+		0x09, 0xF0, // Usage (F0h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xF2, // Report ID (242)
+			0x09, 0x81, // Usage (81h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x25, 0x7F, // Logical Maximum (127)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0xCC, // Report Count (204)
+			0xB1, 0x02, // Feature (Variable)
+		0xC0, // End Collection
+		0x09, 0xF0, // Usage (F0h)
+		0xA1, 0x02, // Collection (Logical)
+			0x85, 0xF4, // Report ID (244)
+			0x09, 0xF4, // Usage (F4h)
+			0x15, 0x00, // Logical Minimum (0)
+			0x26, 0xFF, 0x00, // Logical Maximum (255)
+			0x75, 0x08, // Report Size (8)
+			0x95, 0x03, // Report Count (3)
+			0x91, 0x02, // Output (Variable)
+		0xC0, // End Collection
+	0xC0, // End Collection
+};
+
+enum emulator_mode {
+	EMULATOR_MODE_WALK,
+	EMULATOR_MODE_RANDOM,
+	EMULATOR_MODE_SCRIPT
+};
+
+struct emulator_options {
+	unsigned int report_rate; // input reports per second
+	unsigned int duration; // seconds
+	enum emulator_mode mode;
+	const char *script_path;
+	unsigned int led_rate; // LED notes per second written to the rawmidi port
+	const char *capture_path;
+	const char *midi_path;
+	unsigned int seed;
+};
+
+struct emulator_report {
+	uint8_t size;
+	uint8_t data[MASCHINE_JAM_HID_REPORT_MAX_BYTES];
+};
+
+// Reports that should produce MIDI, in the order they were sent. The MIDI reader pops the head
+// once all of its messages arrived, which gives the end-to-end latency of that report.
+struct emulator_pending_report {
+	uint64_t sent_ns;
+	unsigned int messages_remaining;
+};
+
+struct emulator_latencies {
+	uint64_t *samples;
+	size_t count;
+};
+
+struct emulator_state {
+	struct emulator_options options;
+	int uhid_fd;
+	int midi_fd;
+	FILE *capture_file;
+	volatile bool running;
+	pthread_mutex_t lock;
+
+	// device state as last sent, used to know how many MIDI messages a report should produce
+	uint8_t report01[MASCHINE_JAM_HID_REPORT_01_BYTES];
+	uint8_t report02[MASCHINE_JAM_HID_REPORT_02_BYTES];
+	struct emulator_report *script;
+	size_t script_length;
+
+	struct emulator_pending_report pending[EMULATOR_LATENCY_QUEUE_DEPTH];
+	size_t pending_head;
+	size_t pending_count;
+	uint64_t pending_overflows;
+
+	uint64_t reports_sent[2]; // 0x01, 0x02
+	uint64_t messages_expected;
+	uint64_t messages_received;
+	uint64_t midi_bytes_received;
+	struct emulator_latencies input_latencies;
+
+	uint64_t led_messages_written;
+	uint64_t led_write_pending_ns; // oldest LED write not yet followed by an output report
+	uint64_t output_reports[3]; // 0x80, 0x81, 0x82
+	uint64_t output_reports_other;
+	struct emulator_latencies output_latencies;
+};
+
+static uint64_t emulator_now_ns(void){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
+static void emulator_sleep_until_ns(uint64_t deadline_ns){
+	struct timespec deadline = {
+		.tv_sec = deadline_ns / 1000000000ULL,
+		.tv_nsec = deadline_ns % 1000000000ULL
+	};
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR){
+	}
+}
+static void emulator_latencies_add(struct emulator_latencies *latencies, uint64_t latency_ns){
+	if (latencies->count < EMULATOR_LATENCY_SAMPLES_MAX){
+		latencies->samples[latencies->count++] = latency_ns;
+	}
+}
+static int emulator_compare_u64(const void *a, const void *b){
+	uint64_t left = *(const uint64_t *)a;
+	uint64_t right = *(const uint64_t *)b;
+
+	return (left > right) - (left < right);
+}
+static void emulator_latencies_print(const char *name, struct emulator_latencies *latencies){
+	if (latencies->count == 0){
+		printf("%s latency: no samples\n", name);
+		return;
+	}
+	qsort(latencies->samples, latencies->count, sizeof(uint64_t), emulator_compare_u64);
+	printf("%s latency (us): min %.1f, p50 %.1f, p99 %.1f, max %.1f, samples %zu\n",
+		name,
+		latencies->samples[0] / 1000.0,
+		latencies->samples[latencies->count / 2] / 1000.0,
+		latencies->samples[(latencies->count * 99) / 100] / 1000.0,
+		latencies->samples[latencies->count - 1] / 1000.0,
+		latencies->count
+	);
+}
+
+// uhid
+static int emulator_uhid_write(struct emulator_state *state, struct uhid_event *event){
+	ssize_t written = write(state->uhid_fd, event, sizeof(*event));
+
+	if (written < 0){
+		perror("write /dev/uhid");
+		return -errno;
+	}
+	return written == sizeof(*event) ? 0 : -EFAULT;
+}
+static int emulator_uhid_create(struct emulator_state *state, const char *phys){
+	struct uhid_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.type = UHID_CREATE2;
+	snprintf((char *)event.u.create2.name, sizeof(event.u.create2.name), "Native Instruments Maschine Jam");
+	snprintf((char *)event.u.create2.phys, sizeof(event.u.create2.phys), "%s", phys);
+	snprintf((char *)event.u.create2.uniq, sizeof(event.u.create2.uniq), "EMULATOR");
+	event.u.create2.rd_size = sizeof(maschine_jam_report_descriptor);
+	event.u.create2.bus = BUS_USB;
+	event.u.create2.vendor = MASCHINE_JAM_VENDOR_ID;
+	event.u.create2.product = MASCHINE_JAM_PRODUCT_ID;
+	event.u.create2.version = 0x0039;
+	memcpy(event.u.create2.rd_data, maschine_jam_report_descriptor, sizeof(maschine_jam_report_descriptor));
+	return emulator_uhid_write(state, &event);
+}
+static void emulator_uhid_destroy(struct emulator_state *state){
+	struct uhid_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.type = UHID_DESTROY;
+	emulator_uhid_write(state, &event);
+}
+static int emulator_uhid_send_report(struct emulator_state *state, const uint8_t *data, size_t size){
+	struct uhid_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.type = UHID_INPUT2;
+	event.u.input2.size = size;
+	memcpy(event.u.input2.data, data, size);
+	return emulator_uhid_write(state, &event);
+}
+static void emulator_handle_output_report(struct emulator_state *state, const uint8_t *data, size_t size){
+	uint64_t now_ns = emulator_now_ns();
+	size_t i;
+
+	pthread_mutex_lock(&state->lock);
+	if (size > 0 && data[0] >= 0x80 && data[0] <= 0x82){
+		state->output_reports[data[0] - 0x80]++;
+	} else {
+		state->output_reports_other++;
+	}
+	if (state->led_write_pending_ns != 0){
+		emulator_latencies_add(&state->output_latencies, now_ns - state->led_write_pending_ns);
+		state->led_write_pending_ns = 0;
+	}
+	pthread_mutex_unlock(&state->lock);
+	if (state->capture_file != NULL){
+		fprintf(state->capture_file, "%llu", (unsigned long long)now_ns);
+		for (i = 0; i < size; i++){
+			fprintf(state->capture_file, " %02x", data[i]);
+		}
+		fputc('\n', state->capture_file);
+	}
+}
+// answers the requests hid-core makes of a transport and collects output reports
+static void *emulator_uhid_thread(void *argument){
+	struct emulator_state *state = argument;
+	struct pollfd poll_fd = { .fd = state->uhid_fd, .events = POLLIN };
+	struct uhid_event event, reply;
+	ssize_t length;
+
+	while (state->running){
+		if (poll(&poll_fd, 1, 100) <= 0){
+			continue;
+		}
+		length = read(state->uhid_fd, &event, sizeof(event));
+		if (length <= 0){
+			continue;
+		}
+		switch (event.type){
+			case UHID_OUTPUT:
+				emulator_handle_output_report(state, event.u.output.data, event.u.output.size);
+				break;
+			case UHID_GET_REPORT:
+				memset(&reply, 0, sizeof(reply));
+				reply.type = UHID_GET_REPORT_REPLY;
+				reply.u.get_report_reply.id = event.u.get_report.id;
+				reply.u.get_report_reply.err = EIO;
+				emulator_uhid_write(state, &reply);
+				break;
+			case UHID_SET_REPORT:
+				memset(&reply, 0, sizeof(reply));
+				reply.type = UHID_SET_REPORT_REPLY;
+				reply.u.set_report_reply.id = event.u.set_report.id;
+				reply.u.set_report_reply.err = 0;
+				emulator_uhid_write(state, &reply);
+				break;
+			default:
+				break;
+		}
+	}
+	return NULL;
+}
+
+// Find the rawmidi node of the card the driver created for our uhid device, matched by phys.
+static int emulator_find_midi_device(const char *phys, char *path, size_t path_size){
+	glob_t uevents, midis;
+	char line[256], expected[128], *slash;
+	unsigned int card, device;
+	size_t i;
+	FILE *file;
+	bool found = false;
+
+	snprintf(expected, sizeof(expected), "HID_PHYS=%s\n", phys);
+	if (glob("/sys/bus/hid/devices/*/uevent", 0, NULL, &uevents) != 0){
+		return -ENOENT;
+	}
+	for (i = 0; i < uevents.gl_pathc && !found; i++){
+		file = fopen(uevents.gl_pathv[i], "r");
+		if (file == NULL){
+			continue;
+		}
+		while (fgets(line, sizeof(line), file) != NULL){
+			if (strcmp(line, expected) == 0){
+				found = true;
+				break;
+			}
+		}
+		fclose(file);
+		if (!found){
+			continue;
+		}
+		slash = strrchr(uevents.gl_pathv[i], '/');
+		snprintf(line, sizeof(line), "%.*s/sound/card*/midiC*D*", (int)(slash - uevents.gl_pathv[i]), uevents.gl_pathv[i]);
+		found = false;
+		if (glob(line, 0, NULL, &midis) == 0){
+			slash = strrchr(midis.gl_pathv[0], '/');
+			if (sscanf(slash, "/midiC%uD%u", &card, &device) == 2){
+				snprintf(path, path_size, "/dev/snd/midiC%uD%u", card, device);
+				found = true;
+			}
+			globfree(&midis);
+		}
+	}
+	globfree(&uevents);
+	return found ? 0 : -ENOENT;
+}
+
+// How many MIDI messages hid-maschine-jam emits for a report, given the previous one.
+// Mirrors maschine_jam_process_report01/02 with the default mapping.
+static unsigned int emulator_expected_messages(struct emulator_state *state, const uint8_t *data, size_t size){
+	unsigned int messages = 0;
+	unsigned int i, finger;
+	uint8_t changed;
+	const uint8_t *old_strip, *new_strip;
+	uint16_t old_touch, new_touch;
+
+	if (data[0] == 0x01 && size == MASCHINE_JAM_HID_REPORT_01_BYTES){
+		for (i = 0; i < MASCHINE_JAM_NUMBER_KNOBS; i++){
+			if (((state->report01[1] >> (i * 4)) & 0x0F) != ((data[1] >> (i * 4)) & 0x0F)){
+				messages++;
+			}
+		}
+		for (i = 0; i < MASCHINE_JAM_NUMBER_BUTTONS; i++){
+			changed = (state->report01[2 + (i / 8)] ^ data[2 + (i / 8)]) & (1 << (i % 8));
+			if (changed){
+				messages += (i == MASCHINE_JAM_SHIFT_BUTTON) ? 2 : 1; // shift also sends a sysex
+			}
+		}
+		memcpy(state->report01, data, size);
+	} else if (data[0] == 0x02 && size == MASCHINE_JAM_HID_REPORT_02_BYTES){
+		for (i = 0; i < MASCHINE_JAM_NUMBER_SMARTSTRIPS; i++){
+			old_strip = &state->report02[1 + (i * MASCHINE_JAM_SMARTSTRIP_BYTES)];
+			new_strip = &data[1 + (i * MASCHINE_JAM_SMARTSTRIP_BYTES)];
+			for (finger = 0; finger < MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS; finger++){
+				old_touch = old_strip[2 + (finger * 2)] | ((old_strip[3 + (finger * 2)] & 0x03) << 8);
+				new_touch = new_strip[2 + (finger * 2)] | ((new_strip[3 + (finger * 2)] & 0x03) << 8);
+				if (old_touch == new_touch){
+					continue;
+				}
+				if (old_touch == 0 || new_touch == 0){
+					messages++;
+				}
+				if (new_touch != 0){
+					messages++;
+				}
+			}
+		}
+		memcpy(state->report02, data, size);
+	}
+	return messages;
+}
+
+// Report generators
+static void emulator_next_report(struct emulator_state *state, uint64_t index, struct emulator_report *report){
+	unsigned int button, strip, finger;
+	uint16_t touch;
+	uint8_t *strip_data;
+
+	switch (state->options.mode){
+		case EMULATOR_MODE_WALK:
+			// press then release every button in turn
+			report->size = MASCHINE_JAM_HID_REPORT_01_BYTES;
+			memcpy(report->data, state->report01, report->size);
+			button = (index / 2) % MASCHINE_JAM_NUMBER_BUTTONS;
+			report->data[2 + (button / 8)] ^= 1 << (button % 8);
+			break;
+		case EMULATOR_MODE_RANDOM:
+			if (rand() % 4 != 0){
+				report->size = MASCHINE_JAM_HID_REPORT_01_BYTES;
+				memcpy(report->data, state->report01, report->size);
+				button = rand() % MASCHINE_JAM_NUMBER_BUTTONS;
+				report->data[2 + (button / 8)] ^= 1 << (button % 8);
+				if (rand() % 8 == 0){
+					report->data[1] += 1; // step the first knob
+				}
+			} else {
+				report->size = MASCHINE_JAM_HID_REPORT_02_BYTES;
+				memcpy(report->data, state->report02, report->size);
+				strip = rand() % MASCHINE_JAM_NUMBER_SMARTSTRIPS;
+				finger = rand() % MASCHINE_JAM_NUMBER_SMARTSTRIP_FINGERS;
+				strip_data = &report->data[1 + (strip * MASCHINE_JAM_SMARTSTRIP_BYTES)];
+				touch = (rand() % 3 == 0) ? 0 : rand() % (MASCHINE_JAM_SMARTSTRIP_TOUCH_VALUE_MAX + 1);
+				strip_data[0] += 1; // timestamp
+				strip_data[2 + (finger * 2)] = touch & 0xFF;
+				strip_data[3 + (finger * 2)] = touch >> 8;
+			}
+			break;
+		case EMULATOR_MODE_SCRIPT:
+			*report = state->script[index % state->script_length];
+			break;
+	}
+}
+// one report per line as hex bytes, report id first, '#' starts a comment
+static int emulator_load_script(struct emulator_state *state, const char *path){
+	FILE *file = fopen(path, "r");
+	char line[512], *cursor, *end;
+	struct emulator_report report;
+	unsigned long value;
+
+	if (file == NULL){
+		perror(path);
+		return -errno;
+	}
+	state->script = calloc(EMULATOR_SCRIPT_REPORTS_MAX, sizeof(struct emulator_report));
+	if (state->script == NULL){
+		fclose(file);
+		return -ENOMEM;
+	}
+	while (fgets(line, sizeof(line), file) != NULL && state->script_length < EMULATOR_SCRIPT_REPORTS_MAX){
+		report.size = 0;
+		cursor = line;
+		while (*cursor != '\0' && *cursor != '#' && report.size < MASCHINE_JAM_HID_REPORT_MAX_BYTES){
+			value = strtoul(cursor, &end, 16);
+			if (end == cursor){
+				break;
+			}
+			report.data[report.size++] = value;
+			cursor = end;
+		}
+		if (report.size == 0){
+			continue;
+		}
+		if (!((report.data[0] == 0x01 && report.size == MASCHINE_JAM_HID_REPORT_01_BYTES) || (report.data[0] == 0x02 && report.size == MASCHINE_JAM_HID_REPORT_02_BYTES))){
+			fprintf(stderr, "%s: skipping report 0x%02x of %u bytes\n", path, report.data[0], report.size);
+			continue;
+		}
+		state->script[state->script_length++] = report;
+	}
+	fclose(file);
+	if (state->script_length == 0){
+		fprintf(stderr, "%s: no reports\n", path);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+// MIDI reader: counts complete messages the driver delivered and pops the latency queue
+static void emulator_midi_message_received(struct emulator_state *state, uint64_t now_ns){
+	struct emulator_pending_report *head;
+
+	pthread_mutex_lock(&state->lock);
+	state->messages_received++;
+	if (state->pending_count > 0){
+		head = &state->pending[state->pending_head];
+		if (--head->messages_remaining == 0){
+			emulator_latencies_add(&state->input_latencies, now_ns - head->sent_ns);
+			state->pending_head = (state->pending_head + 1) % EMULATOR_LATENCY_QUEUE_DEPTH;
+			state->pending_count--;
+		}
+	}
+	pthread_mutex_unlock(&state->lock);
+}
+static void *emulator_midi_thread(void *argument){
+	struct emulator_state *state = argument;
+	struct pollfd poll_fd = { .fd = state->midi_fd, .events = POLLIN };
+	uint8_t buffer[1024], byte, running_status = 0;
+	unsigned int data_length = 0;
+	bool in_sysex = false;
+	uint64_t now_ns;
+	ssize_t length, i;
+
+	while (state->running){
+		if (poll(&poll_fd, 1, 100) <= 0){
+			continue;
+		}
+		length = read(state->midi_fd, buffer, sizeof(buffer));
+		if (length <= 0){
+			continue;
+		}
+		now_ns = emulator_now_ns();
+		pthread_mutex_lock(&state->lock);
+		state->midi_bytes_received += length;
+		pthread_mutex_unlock(&state->lock);
+		for (i = 0; i < length; i++){
+			byte = buffer[i];
+			if (byte >= 0xF8){
+				continue;
+			}
+			if (byte == 0xF0){
+				in_sysex = true;
+				running_status = 0;
+				continue;
+			}
+			if (byte == 0xF7){
+				if (in_sysex){
+					emulator_midi_message_received(state, now_ns);
+				}
+				in_sysex = false;
+				continue;
+			}
+			if (byte & 0x80){
+				in_sysex = false;
+				running_status = byte < 0xF0 ? byte : 0;
+				data_length = 0;
+				continue;
+			}
+			if (in_sysex || running_status == 0){
+				continue;
+			}
+			data_length++;
+			if (data_length == (((running_status & 0xF0) == 0xC0 || (running_status & 0xF0) == 0xD0) ? 1u : 2u)){
+				data_length = 0;
+				emulator_midi_message_received(state, now_ns);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void emulator_send_input_report(struct emulator_state *state, uint64_t index){
+	struct emulator_report report;
+	struct emulator_pending_report *pending;
+	unsigned int messages;
+
+	emulator_next_report(state, index, &report);
+	messages = emulator_expected_messages(state, report.data, report.size);
+	pthread_mutex_lock(&state->lock);
+	if (messages > 0){
+		if (state->pending_count < EMULATOR_LATENCY_QUEUE_DEPTH){
+			pending = &state->pending[(state->pending_head + state->pending_count) % EMULATOR_LATENCY_QUEUE_DEPTH];
+			pending->sent_ns = emulator_now_ns();
+			pending->messages_remaining = messages;
+			state->pending_count++;
+		} else {
+			state->pending_overflows++;
+		}
+		state->messages_expected += messages;
+	}
+	state->reports_sent[report.data[0] == 0x01 ? 0 : 1]++;
+	pthread_mutex_unlock(&state->lock);
+	emulator_uhid_send_report(state, report.data, report.size);
+}
+static void emulator_write_led_message(struct emulator_state *state, uint64_t index){
+	// note 0 on channel 0 is what every LED listens to with the default mapping
+	uint8_t message[3] = { 0x90, 0x00, index % 128 };
+
+	pthread_mutex_lock(&state->lock);
+	if (state->led_write_pending_ns == 0){
+		state->led_write_pending_ns = emulator_now_ns();
+	}
+	state->led_messages_written++;
+	pthread_mutex_unlock(&state->lock);
+	if (write(state->midi_fd, message, sizeof(message)) != sizeof(message)){
+		perror("write midi");
+	}
+}
+static void emulator_run(struct emulator_state *state){
+	uint64_t start_ns = emulator_now_ns();
+	uint64_t end_ns = start_ns + (state->options.duration * 1000000000ULL);
+	uint64_t report_period_ns = state->options.report_rate ? 1000000000ULL / state->options.report_rate : 0;
+	uint64_t led_period_ns = state->options.led_rate ? 1000000000ULL / state->options.led_rate : 0;
+	uint64_t next_report_ns = start_ns, next_led_ns = start_ns, next_ns;
+	uint64_t report_index = 0, led_index = 0;
+
+	while (state->running){
+		next_ns = end_ns;
+		if (report_period_ns && next_report_ns < next_ns){
+			next_ns = next_report_ns;
+		}
+		if (led_period_ns && next_led_ns < next_ns){
+			next_ns = next_led_ns;
+		}
+		emulator_sleep_until_ns(next_ns);
+		if (next_ns >= end_ns){
+			break;
+		}
+		if (report_period_ns && next_ns == next_report_ns){
+			emulator_send_input_report(state, report_index++);
+			next_report_ns += report_period_ns;
+		}
+		if (led_period_ns && next_ns == next_led_ns){
+			emulator_write_led_message(state, led_index++);
+			next_led_ns += led_period_ns;
+		}
+	}
+}
+static void emulator_print_summary(struct emulator_state *state, double seconds){
+	uint64_t reports = state->reports_sent[0] + state->reports_sent[1];
+	uint64_t missing = state->messages_expected > state->messages_received ? state->messages_expected - state->messages_received : 0;
+
+	printf("input: %llu reports (0x01: %llu, 0x02: %llu), %.0f reports/sec\n",
+		(unsigned long long)reports,
+		(unsigned long long)state->reports_sent[0],
+		(unsigned long long)state->reports_sent[1],
+		reports / seconds
+	);
+	printf("midi: %llu/%llu messages received, %.0f events/sec, %llu dropped, %llu bytes\n",
+		(unsigned long long)state->messages_received,
+		(unsigned long long)state->messages_expected,
+		state->messages_received / seconds,
+		(unsigned long long)missing,
+		(unsigned long long)state->midi_bytes_received
+	);
+	if (state->pending_overflows != 0){
+		printf("midi: %llu reports not timed, latency queue full\n", (unsigned long long)state->pending_overflows);
+	}
+	emulator_latencies_print("input to rawmidi", &state->input_latencies);
+	printf("output: %llu LED messages written, reports 0x80: %llu, 0x81: %llu, 0x82: %llu, other: %llu\n",
+		(unsigned long long)state->led_messages_written,
+		(unsigned long long)state->output_reports[0],
+		(unsigned long long)state->output_reports[1],
+		(unsigned long long)state->output_reports[2],
+		(unsigned long long)state->output_reports_other
+	);
+	if (state->led_messages_written != 0){
+		emulator_latencies_print("rawmidi to output report", &state->output_latencies);
+	}
+}
+
+static void emulator_usage(const char *name){
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -r RATE     input reports per second (default 1000)\n"
+		"  -d SECONDS  run time (default 10)\n"
+		"  -m MODE     walk, random or script (default walk)\n"
+		"  -f FILE     script of hex reports, one per line, implies -m script\n"
+		"  -l RATE     LED notes per second written to the rawmidi port (default 0)\n"
+		"  -o FILE     capture output reports with timestamps\n"
+		"  -M DEVICE   rawmidi device, found from sysfs by default\n"
+		"  -s SEED     random seed\n",
+		name
+	);
+}
+static int emulator_parse_options(struct emulator_options *options, int argc, char **argv){
+	int option;
+
+	options->report_rate = 1000;
+	options->duration = 10;
+	options->mode = EMULATOR_MODE_WALK;
+	options->script_path = NULL;
+	options->led_rate = 0;
+	options->capture_path = NULL;
+	options->midi_path = NULL;
+	options->seed = time(NULL);
+	while ((option = getopt(argc, argv, "r:d:m:f:l:o:M:s:h")) != -1){
+		switch (option){
+			case 'r':
+				options->report_rate = strtoul(optarg, NULL, 0);
+				break;
+			case 'd':
+				options->duration = strtoul(optarg, NULL, 0);
+				break;
+			case 'm':
+				if (strcmp(optarg, "walk") == 0){
+					options->mode = EMULATOR_MODE_WALK;
+				} else if (strcmp(optarg, "random") == 0){
+					options->mode = EMULATOR_MODE_RANDOM;
+				} else if (strcmp(optarg, "script") == 0){
+					options->mode = EMULATOR_MODE_SCRIPT;
+				} else {
+					return -EINVAL;
+				}
+				break;
+			case 'f':
+				options->script_path = optarg;
+				options->mode = EMULATOR_MODE_SCRIPT;
+				break;
+			case 'l':
+				options->led_rate = strtoul(optarg, NULL, 0);
+				break;
+			case 'o':
+				options->capture_path = optarg;
+				break;
+			case 'M':
+				options->midi_path = optarg;
+				break;
+			case 's':
+				options->seed = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				return -EINVAL;
+		}
+	}
+	if (options->mode == EMULATOR_MODE_SCRIPT && options->script_path == NULL){
+		return -EINVAL;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv){
+	static struct emulator_state state;
+	pthread_t uhid_thread, midi_thread;
+	char phys[64], midi_path[64];
+	uint64_t start_ns, waited_ms;
+	double run_seconds;
+	int error_code;
+
+	if (emulator_parse_options(&state.options, argc, argv) != 0){
+		emulator_usage(argv[0]);
+		return 1;
+	}
+	srand(state.options.seed);
+	pthread_mutex_init(&state.lock, NULL);
+	state.input_latencies.samples = calloc(EMULATOR_LATENCY_SAMPLES_MAX, sizeof(uint64_t));
+	state.output_latencies.samples = calloc(EMULATOR_LATENCY_SAMPLES_MAX, sizeof(uint64_t));
+	if (state.input_latencies.samples == NULL || state.output_latencies.samples == NULL){
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	state.report01[0] = 0x01;
+	state.report02[0] = 0x02;
+	if (state.options.mode == EMULATOR_MODE_SCRIPT && emulator_load_script(&state, state.options.script_path) != 0){
+		return 1;
+	}
+	if (state.options.capture_path != NULL){
+		state.capture_file = fopen(state.options.capture_path, "w");
+		if (state.capture_file == NULL){
+			perror(state.options.capture_path);
+			return 1;
+		}
+	}
+
+	state.uhid_fd = open("/dev/uhid", O_RDWR | O_CLOEXEC);
+	if (state.uhid_fd < 0){
+		perror("/dev/uhid");
+		return 1;
+	}
+	snprintf(phys, sizeof(phys), "maschine-jam-emulator/%d", (int)getpid());
+	if (emulator_uhid_create(&state, phys) != 0){
+		return 1;
+	}
+	state.running = true;
+	pthread_create(&uhid_thread, NULL, emulator_uhid_thread, &state);
+
+	// wait for hid-maschine-jam to bind and register its sound card
+	if (state.options.midi_path != NULL){
+		snprintf(midi_path, sizeof(midi_path), "%s", state.options.midi_path);
+	} else {
+		for (waited_ms = 0; waited_ms < EMULATOR_DEVICE_WAIT_MS; waited_ms += 50){
+			if (emulator_find_midi_device(phys, midi_path, sizeof(midi_path)) == 0){
+				break;
+			}
+			usleep(50 * 1000);
+		}
+		if (waited_ms >= EMULATOR_DEVICE_WAIT_MS){
+			fprintf(stderr, "no rawmidi device appeared for %s, is hid-maschine-jam loaded?\n", phys);
+			error_code = 1;
+			goto destroy_device;
+		}
+	}
+	state.midi_fd = open(midi_path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (state.midi_fd < 0){
+		perror(midi_path);
+		error_code = 1;
+		goto destroy_device;
+	}
+	printf("emulating Maschine Jam on %s, rawmidi %s\n", phys, midi_path);
+	pthread_create(&midi_thread, NULL, emulator_midi_thread, &state);
+
+	start_ns = emulator_now_ns();
+	emulator_run(&state);
+	run_seconds = (emulator_now_ns() - start_ns) / 1e9;
+	// let the driver drain what is still queued
+	usleep(200 * 1000);
+	state.running = false;
+	pthread_join(midi_thread, NULL);
+	emulator_print_summary(&state, run_seconds);
+	close(state.midi_fd);
+	error_code = state.messages_received < state.messages_expected ? 2 : 0;
+
+destroy_device:
+	state.running = false;
+	pthread_join(uhid_thread, NULL);
+	emulator_uhid_destroy(&state);
+	close(state.uhid_fd);
+	if (state.capture_file != NULL){
+		fclose(state.capture_file);
+	}
+	return error_code;
+}